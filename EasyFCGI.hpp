@@ -1,6 +1,5 @@
 #ifndef _EASY_FCGI_HPP
 #define _EASY_FCGI_HPP
-#include <fcgiapp.h>
 #include <csignal>
 #include <memory>
 #include <concepts>
@@ -9,6 +8,7 @@
 #include <ranges>
 #include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cstdlib>
 #include <filesystem>
 #include <chrono>
@@ -16,9 +16,34 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/poll.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <limits>
+#include <cstring>
+#include <cerrno>
+#include <span>
 #include <thread>
 #include <stop_token>
+#include <mutex>
+#include <map>
+#include <deque>
+#include <memory_resource>
+#if defined( __AVX2__ ) || defined( __SSE2__ )
+#include <immintrin.h>
+#endif
 #include "json.hpp"
+#include "glaze/json.hpp"
+#include "EasyMeta.h"
 
 using namespace std::chrono_literals;
 using namespace std::string_literals;
@@ -368,20 +393,88 @@ namespace ParseUtil
     }
 
     [[nodiscard]]
-    static auto DecodeURLFragment( StrView Fragment )
+    constexpr auto HexValue( char C ) noexcept -> unsigned
+    {
+        if( C >= '0' && C <= '9' ) return C - '0';
+        C |= 0x20;
+        if( C >= 'a' && C <= 'f' ) return C - 'a' + 10;
+        return 16;
+    }
+
+    // first '%' or '+' in [First, Last), 32 / 16 bytes per step with AVX2 / SSE2
+    [[nodiscard]]
+    static auto FindURLEscape( const char* First, const char* Last ) noexcept -> const char*
     {
-        constexpr auto EncodeDigitWidth = 2;
-        auto Result = std::string{};
-        auto [FirstPart, OtherParts] = Fragment | SplitBy( '%' ) | SplitAt( 1 );
-        for( auto LeadingText : FirstPart ) Result += LeadingText | RestoreSpaceChar;
-        for( auto Segment : OtherParts )
+#ifdef __AVX2__
+        for( ; Last - First >= 32; First += 32 )
+        {
+            auto Block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( First ) );
+            auto Hits = _mm256_or_si256( _mm256_cmpeq_epi8( Block, _mm256_set1_epi8( '%' ) ), _mm256_cmpeq_epi8( Block, _mm256_set1_epi8( '+' ) ) );
+            if( auto Mask = static_cast<unsigned>( _mm256_movemask_epi8( Hits ) ) ) return First + std::countr_zero( Mask );
+        }
+#endif
+#ifdef __SSE2__
+        for( ; Last - First >= 16; First += 16 )
         {
-            auto [Encoded, Unencoded] = Segment | SplitAt( EncodeDigitWidth );
-            Result += Encoded.length() >= EncodeDigitWidth ? HexToChar( Encoded ) : '?';
-            Result += Unencoded | RestoreSpaceChar;
+            auto Block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( First ) );
+            auto Hits = _mm_or_si128( _mm_cmpeq_epi8( Block, _mm_set1_epi8( '%' ) ), _mm_cmpeq_epi8( Block, _mm_set1_epi8( '+' ) ) );
+            if( auto Mask = static_cast<unsigned>( _mm_movemask_epi8( Hits ) ) ) return First + std::countr_zero( Mask );
+        }
+#endif
+        for( ; First != Last; ++First )
+            if( *First == '%' || *First == '+' ) return First;
+        return Last;
+    }
+
+    // decoded text of Fragment written to Output, returns its length, never more than Fragment.size()
+    // Output may be Fragment.data() itself, writing never overtakes reading
+    // clean runs between escapes are moved as a whole, a malformed or truncated escape becomes '?'
+    static auto DecodeURLInto( StrView Fragment, char* Output ) noexcept -> std::size_t
+    {
+        auto Cursor = Fragment.data();
+        auto Last = Cursor + Fragment.size();
+        auto Write = Output;
+        while( Cursor != Last )
+        {
+            auto Escape = FindURLEscape( Cursor, Last );
+            if( Write != Cursor ) std::memmove( Write, Cursor, Escape - Cursor );
+            Write += Escape - Cursor;
+            Cursor = Escape;
+            if( Cursor == Last ) break;
+            if( *Cursor == '+' )
+            {
+                *Write++ = ' ';
+                ++Cursor;
+                continue;
+            }
+            auto High = Last - Cursor > 1 ? HexValue( Cursor[1] ) : 16;
+            auto Low = High < 16 && Last - Cursor > 2 ? HexValue( Cursor[2] ) : 16;
+            if( Low < 16 )
+            {
+                *Write++ = static_cast<char>( High << 4 | Low );
+                Cursor += 3;
+                continue;
+            }
+            // malformed, only '%' and the hex digit after it are taken, "%%41" is "?A"
+            *Write++ = '?';
+            Cursor += High < 16 ? 2 : 1;
         }
-        return Result;
+        return Write - Output;
+    }
+
+    // appends decoded text to Result, which may carry any allocator
+    template<typename StringType>
+    [[nodiscard]]
+    static auto DecodeURLFragment( StrView Fragment, StringType&& Result ) -> StringType
+    {
+        auto Start = Result.size();
+        Result.resize_and_overwrite( Start + Fragment.size(),
+                                     [&]( char* Buffer, std::size_t ) { return Start + DecodeURLInto( Fragment, Buffer + Start ); } );
+        return std::forward<StringType>( Result );
     }
+
+    [[nodiscard]]
+    static auto DecodeURLFragment( StrView Fragment ) -> std::string { return DecodeURLFragment( Fragment, std::string{} ); }
 };  // namespace ParseUtil
 
 namespace HTTP
@@ -394,12 +487,14 @@ namespace HTTP
         Created = 201,
         Accepted = 202,
         NoContent = 204,
+        PartialContent = 206,
         BadRequest = 400,
         Unauthorized = 401,
         Forbidden = 403,
         NotFound = 404,
         MethodNotAllowed = 405,
         UnsupportedMediaType = 415,
+        RangeNotSatisfiable = 416,
         UnprocessableEntity = 422,
         InternalServerError = 500,
         NotImplemented = 501,
@@ -411,24 +506,24 @@ namespace HTTP
         enum class EnumValue : unsigned short { INVALID, GET, HEAD, POST, PUT, DELETE, CONNECT, OPTIONS, TRACE, PATCH };
         EnumValue Verb;
 
-#define RETURN_IF( N ) \
-    if( VerbName == #N ) return N
-        static constexpr auto FromStringView( std::string_view VerbName )
-        {
+#define VERB_ENTRY( N ) { #N, N }
+        static constexpr auto Verbs = [] {
             using enum EnumValue;
-            RETURN_IF( GET );
-            RETURN_IF( PUT );
-            RETURN_IF( POST );
-            RETURN_IF( HEAD );
-            RETURN_IF( PATCH );
-            RETURN_IF( TRACE );
-            RETURN_IF( DELETE );
-            RETURN_IF( OPTIONS );
-            RETURN_IF( CONNECT );
-            RETURN_IF( INVALID );
-            return INVALID;
-        }
-#undef RETURN_IF
+            return EasyMeta::MakePerfectHash<std::string_view, EnumValue>( {
+                VERB_ENTRY( GET ),
+                VERB_ENTRY( PUT ),
+                VERB_ENTRY( POST ),
+                VERB_ENTRY( HEAD ),
+                VERB_ENTRY( PATCH ),
+                VERB_ENTRY( TRACE ),
+                VERB_ENTRY( DELETE ),
+                VERB_ENTRY( OPTIONS ),
+                VERB_ENTRY( CONNECT ),
+                VERB_ENTRY( INVALID ),
+            } );
+        }();
+#undef VERB_ENTRY
+        static constexpr auto FromStringView( std::string_view VerbName ) { return Verbs.FindOr( VerbName, EnumValue::INVALID ); }
 
 #define RETURN_CASE( N ) \
     case N : return #N
@@ -501,21 +596,31 @@ namespace HTTP
         };
         EnumValue Type;
 
-        static constexpr auto FromStringView( std::string_view TypeName )
-        {
+        static constexpr auto Types = [] {
             using enum EnumValue;
-            if( TypeName == "text/plain" ) return TEXT_PLAIN;
-            if( TypeName == "text/html" ) return TEXT_HTML;
-            if( TypeName == "text/xml" ) return TEXT_XML;
-            if( TypeName == "text/csv" ) return TEXT_CSV;
-            if( TypeName == "text/css" ) return TEXT_CSS;
-            if( TypeName == "text/event-stream" ) return TEXT_EVENT_STREAM;
-            if( TypeName == "application/json" ) return APPLICATION_JSON;
-            if( TypeName == "application/x-www-form-urlencoded" ) return APPLICATION_X_WWW_FORM_URLENCODED;
-            if( TypeName == "application/octet-stream" ) return APPLICATION_OCTET_STREAM;
-            if( TypeName == "multipart/form-data" ) return MULTIPART_FORM_DATA;
-            if( TypeName == "multipart/byteranges" ) return MULTIPART_BYTERANGES;
-            return UNKNOWN_MIME_TYPE;
+            return EasyMeta::MakePerfectHash<std::string_view, EnumValue>( {
+                { "text/plain", TEXT_PLAIN },
+                { "text/html", TEXT_HTML },
+                { "text/xml", TEXT_XML },
+                { "text/csv", TEXT_CSV },
+                { "text/css", TEXT_CSS },
+                { "text/event-stream", TEXT_EVENT_STREAM },
+                { "application/json", APPLICATION_JSON },
+                { "application/x-www-form-urlencoded", APPLICATION_X_WWW_FORM_URLENCODED },
+                { "application/octet-stream", APPLICATION_OCTET_STREAM },
+                { "multipart/form-data", MULTIPART_FORM_DATA },
+                { "multipart/byteranges", MULTIPART_BYTERANGES },
+            } );
+        }();
+        static constexpr auto FromStringView( std::string_view TypeName ) { return Types.FindOr( TypeName, EnumValue::UNKNOWN_MIME_TYPE ); }
+
+        // media type of a Content-Type field, parameters and surrounding spaces dropped
+        static constexpr auto MediaType( std::string_view Field )
+        {
+            Field = Field.substr( 0, Field.find( ';' ) );
+            auto First = Field.find_first_not_of( " \t" );
+            if( First == Field.npos ) return std::string_view{};
+            return Field.substr( First, Field.find_last_not_of( " \t" ) + 1 - First );
         }
 
         static constexpr auto ToStringView( EnumValue Type ) -> std::string_view
@@ -543,7 +648,7 @@ namespace HTTP
         constexpr ContentType() = default;
         constexpr ContentType( const ContentType& ) = default;
         constexpr ContentType( EnumValue Other ) : Type{ Other } {}
-        constexpr ContentType( std::string_view TypeName ) : Type{ FromStringView( TypeName | PU::SplitBy( ';' ) | PU::Front | PU::TrimSpace ) } {}
+        constexpr ContentType( std::string_view TypeName ) : Type{ FromStringView( MediaType( TypeName ) ) } {}
 
         using FormatAs = std::string_view;
         constexpr operator std::string_view() const { return ToStringView( Type ); }
@@ -581,8 +686,284 @@ namespace HTTP
             };
         }  // namespace Type
     }  // namespace Content
+
+    // "Status: ...\r\nContent-Type: ...; charset=UTF-8\r\n" rendered at compile time for every pair of
+    // status code and content type, FlushHeader copies one of these instead of formatting
+    namespace PreRendered
+    {
+        using enum StatusCode;
+        constexpr StatusCode CachedStatusCodes[] = {
+            OK, Created, Accepted, PartialContent, BadRequest, Unauthorized, Forbidden, NotFound,
+            MethodNotAllowed, UnsupportedMediaType, RangeNotSatisfiable, UnprocessableEntity, InternalServerError, NotImplemented, ServiceUnavailable,
+        };
+        constexpr auto ContentTypeCount = std::to_underlying( ContentType::EnumValue::UNKNOWN_MIME_TYPE ) + 1uz;
+        constexpr auto StatusLineSize = std::string_view{ "Status: 200\r\n" }.size();
+
+        struct Block
+        {
+            std::array<char, 80> Text{};
+            std::size_t Size{ 0 };
+
+            constexpr auto Append( std::string_view Piece )
+            {
+                for( auto C : Piece ) Text[Size++] = C;
+            }
+            constexpr operator std::string_view() const { return { Text.data(), Size }; }
+        };
+
+        // 0 for status codes not cached
+        constexpr auto Rows = [] {
+            auto Result = std::array<std::pair<StatusCode, unsigned char>, std::size( CachedStatusCodes )>{};
+            for( auto Row = 0uz; Row < std::size( CachedStatusCodes ); ++Row ) Result[Row] = { CachedStatusCodes[Row], Row + 1 };
+            return EasyMeta::MakePerfectHash( Result );
+        }();
+
+        constexpr auto Blocks = [] {
+            auto Result = std::array<std::array<Block, ContentTypeCount>, std::size( CachedStatusCodes ) + 1>{};
+            for( auto Row = 0uz; Row < std::size( CachedStatusCodes ); ++Row )
+                for( auto Column = 0uz; Column < ContentTypeCount; ++Column )
+                {
+                    auto Code = std::to_underlying( CachedStatusCodes[Row] );
+                    auto& Target = Result[Row + 1][Column];
+                    Target.Append( "Status: " );
+                    const char Digits[] = { static_cast<char>( '0' + Code / 100 ), static_cast<char>( '0' + Code / 10 % 10 ), static_cast<char>( '0' + Code % 10 ) };
+                    Target.Append( { Digits, 3 } );
+                    Target.Append( "\r\nContent-Type: " );
+                    Target.Append( ContentType::ToStringView( static_cast<ContentType::EnumValue>( Column ) ) );
+                    Target.Append( "; charset=UTF-8\r\n" );
+                }
+            return Result;
+        }();
+
+        // empty if not cached
+        constexpr auto Lookup( StatusCode Code, ContentType Type ) -> std::string_view
+        {
+            if( Type == Content::MultiPart::ByteRanges ) return {};
+            return Blocks[Rows.FindOr( Code, 0 )][std::to_underlying( Type.Type )];
+        }
+
+        // "Status: ...\r\n" alone, empty if not cached
+        constexpr auto StatusLine( StatusCode Code ) -> std::string_view
+        {
+            return std::string_view{ Blocks[Rows.FindOr( Code, 0 )][0] }.substr( 0, StatusLineSize );
+        }
+    }  // namespace PreRendered
+
+    struct ByteRange
+    {
+        std::size_t First, Length;
+    };
+
+    // more ranges in one request are not worth serving piecewise
+    constexpr auto ByteRangeLimit = 16uz;
+
+    // Range request field against a representation of Total bytes
+    // nullopt if malformed or not in bytes, the whole representation is served then
+    // likewise beyond ByteRangeLimit ranges or when the ranges add up to more than Total, RFC 9110 14.2
+    // empty if no range is satisfiable, otherwise sorted with overlapping and adjacent ranges merged
+    inline auto ParseByteRanges( std::string_view Field, std::size_t Total ) -> std::optional<std::vector<ByteRange>>
+    {
+        using namespace PU;
+        Field = Field | TrimSpace;
+        if( ! Field.starts_with( "bytes=" ) ) return std::nullopt;
+        // 1*DIGIT only, no sign, beyond size_t saturates, it is clamped to Total anyway
+        auto Position = []( std::string_view Digits ) -> std::optional<std::size_t> {
+            if( Digits.empty() || ! RNG::all_of( Digits, []( char C ) { return C >= '0' && C <= '9'; } ) ) return std::nullopt;
+            auto Result = std::size_t{};
+            if( std::from_chars( Digits.data(), Digits.data() + Digits.size(), Result ).ec != std::errc{} ) return std::numeric_limits<std::size_t>::max();
+            return Result;
+        };
+        auto Ranges = std::vector<ByteRange>{};
+        auto SpecCount = 0uz;
+        for( auto Spec : Field.substr( 6 ) | SplitBy( ',' ) | VIEW::transform( TrimSpace ) )
+        {
+            if( Spec.empty() ) continue;
+            if( ! Spec.contains( '-' ) || ++SpecCount > ByteRangeLimit ) return std::nullopt;
+            auto [HeadField, TailField] = Spec | SplitOnceBy( '-' );
+            auto Head = HeadField | TrimSpace;
+            auto Tail = TailField | TrimSpace;
+            auto First = Position( Head );
+            auto Last = Position( Tail );
+            if( Head.empty() )  // suffix, last N bytes
+            {
+                if( ! Last ) return std::nullopt;
+                if( auto N = std::min( *Last, Total ); N > 0 ) Ranges.push_back( { Total - N, N } );
+                continue;
+            }
+            if( ! First || ( ! Tail.empty() && ( ! Last || *Last < *First ) ) ) return std::nullopt;
+            if( *First >= Total ) continue;
+            Ranges.push_back( { *First, std::min( Last.value_or( Total - 1 ), Total - 1 ) - *First + 1 } );
+        }
+
+        auto Requested = 0uz;
+        for( auto [First, Length] : Ranges ) Requested += Length;
+        if( Requested > Total ) return std::nullopt;
+
+        RNG::sort( Ranges, {}, &ByteRange::First );
+        auto Merged = std::vector<ByteRange>{};
+        for( auto Range : Ranges )
+            if( Merged.empty() || Range.First > Merged.back().First + Merged.back().Length ) Merged.push_back( Range );
+            else Merged.back().Length = std::max( Merged.back().Length, Range.First + Range.Length - Merged.back().First );
+        return Merged;
+    }
 }  // namespace HTTP
 
+// FastCGI protocol 1.0 records
+// https://fastcgi-archives.github.io/FastCGI_Specification.html
+namespace FastCGI
+{
+    using StrView = std::string_view;
+
+    constexpr auto Version = std::uint8_t{ 1 };
+    constexpr auto HeaderLength = 8uz;
+    constexpr auto MaxContentLength = 0xFFFFuz;
+    constexpr auto MaxRecordLength = HeaderLength + MaxContentLength + 0xFFuz;
+    constexpr auto NullRequestID = std::uint16_t{ 0 };
+    constexpr auto KeepConnectionFlag = std::uint8_t{ 1 };
+
+    enum class RecordType : std::uint8_t {
+        BeginRequest = 1,
+        AbortRequest = 2,
+        EndRequest = 3,
+        Params = 4,
+        Stdin = 5,
+        Stdout = 6,
+        Stderr = 7,
+        Data = 8,
+        GetValues = 9,
+        GetValuesResult = 10,
+        UnknownType = 11,
+    };
+
+    enum class Role : std::uint16_t { Responder = 1, Authorizer = 2, Filter = 3 };
+
+    enum class ProtocolStatus : std::uint8_t {
+        RequestComplete = 0,
+        CantMultiplexConnection = 1,
+        Overloaded = 2,
+        UnknownRole = 3,
+    };
+
+    using RawHeader = std::array<char, HeaderLength>;
+    using RawBody = std::array<char, 8>;  // BeginRequest / EndRequest / UnknownType bodies
+
+    struct RecordHeader
+    {
+        std::uint8_t Version;
+        RecordType Type;
+        std::uint16_t RequestID;
+        std::uint16_t ContentLength;
+        std::uint8_t PaddingLength;
+
+        static constexpr auto Decode( const char* Raw ) -> RecordHeader
+        {
+            auto Byte = [Raw]( std::size_t I ) { return static_cast<std::uint8_t>( Raw[I] ); };
+            return { .Version = Byte( 0 ),
+                     .Type = static_cast<RecordType>( Byte( 1 ) ),
+                     .RequestID = static_cast<std::uint16_t>( Byte( 2 ) << 8 | Byte( 3 ) ),
+                     .ContentLength = static_cast<std::uint16_t>( Byte( 4 ) << 8 | Byte( 5 ) ),
+                     .PaddingLength = Byte( 6 ) };
+        }
+
+        constexpr auto RecordLength() const { return HeaderLength + ContentLength + PaddingLength; }
+    };
+
+    constexpr auto EncodeHeader( RecordType Type, std::uint16_t RequestID, std::size_t ContentLength, std::uint8_t PaddingLength = 0 ) -> RawHeader
+    {
+        return { static_cast<char>( Version ),
+                 static_cast<char>( Type ),
+                 static_cast<char>( RequestID >> 8 ),
+                 static_cast<char>( RequestID & 0xFF ),
+                 static_cast<char>( ContentLength >> 8 ),
+                 static_cast<char>( ContentLength & 0xFF ),
+                 static_cast<char>( PaddingLength ),
+                 0 };
+    }
+
+    constexpr auto EncodeEndRequestBody( std::uint32_t AppStatus, ProtocolStatus Status ) -> RawBody
+    {
+        return { static_cast<char>( AppStatus >> 24 ),
+                 static_cast<char>( AppStatus >> 16 & 0xFF ),
+                 static_cast<char>( AppStatus >> 8 & 0xFF ),
+                 static_cast<char>( AppStatus & 0xFF ),
+                 static_cast<char>( Status ),
+                 0,
+                 0,
+                 0 };
+    }
+
+    constexpr auto EncodeUnknownTypeBody( RecordType Type ) -> RawBody { return { static_cast<char>( Type ), 0, 0, 0, 0, 0, 0, 0 }; }
+
+    struct BeginRequestBody
+    {
+        FastCGI::Role Role;
+        std::uint8_t Flags;
+
+        static constexpr auto Decode( StrView Content ) -> BeginRequestBody
+        {
+            if( Content.size() < 3 ) return { static_cast<FastCGI::Role>( 0 ), 0 };
+            auto Byte = [Content]( std::size_t I ) { return static_cast<std::uint8_t>( Content[I] ); };
+            return { static_cast<FastCGI::Role>( Byte( 0 ) << 8 | Byte( 1 ) ), Byte( 2 ) };
+        }
+    };
+
+    // name-value pair length: 1 byte if < 128, otherwise 4 bytes with high bit set
+    constexpr auto DecodeLength( StrView& Input ) -> std::optional<std::size_t>
+    {
+        if( Input.empty() ) return std::nullopt;
+        auto Byte = [&Input]( std::size_t I ) { return static_cast<std::size_t>( static_cast<std::uint8_t>( Input[I] ) ); };
+        if( Byte( 0 ) < 0x80 )
+        {
+            auto Length = Byte( 0 );
+            Input.remove_prefix( 1 );
+            return Length;
+        }
+        if( Input.size() < 4 ) return std::nullopt;
+        auto Length = ( Byte( 0 ) & 0x7F ) << 24 | Byte( 1 ) << 16 | Byte( 2 ) << 8 | Byte( 3 );
+        Input.remove_prefix( 4 );
+        return Length;
+    }
+
+    // consumes one pair from the front of Input, views point into Input
+    constexpr auto DecodeNameValuePair( StrView& Input ) -> std::optional<std::pair<StrView, StrView>>
+    {
+        auto Remain = Input;
+        auto NameLength = DecodeLength( Remain );
+        auto ValueLength = DecodeLength( Remain );
+        if( ! NameLength || ! ValueLength || *NameLength + *ValueLength > Remain.size() ) return std::nullopt;
+        auto Name = Remain.substr( 0, *NameLength );
+        auto Value = Remain.substr( *NameLength, *ValueLength );
+        Input = Remain.substr( *NameLength + *ValueLength );
+        return std::pair{ Name, Value };
+    }
+
+    constexpr auto EncodeLength( std::string& Output, std::size_t Length )
+    {
+        if( Length < 0x80 ) { Output += static_cast<char>( Length ); }
+        else
+        {
+            Output += static_cast<char>( Length >> 24 | 0x80 );
+            Output += static_cast<char>( Length >> 16 & 0xFF );
+            Output += static_cast<char>( Length >> 8 & 0xFF );
+            Output += static_cast<char>( Length & 0xFF );
+        }
+    }
+
+    constexpr auto EncodeNameValuePair( std::string& Output, StrView Name, StrView Value )
+    {
+        EncodeLength( Output, Name.size() );
+        EncodeLength( Output, Value.size() );
+        Output.append( Name ).append( Value );
+    }
+
+    namespace ManagementVariable
+    {
+        constexpr auto MaxConnections = StrView{ "FCGI_MAX_CONNS" };
+        constexpr auto MaxRequests = StrView{ "FCGI_MAX_REQS" };
+        constexpr auto MultiplexConnections = StrView{ "FCGI_MPXS_CONNS" };
+    }  // namespace ManagementVariable
+}  // namespace FastCGI
+
 namespace EasyFCGI
 {
     namespace FS = std::filesystem;
@@ -598,8 +979,18 @@ namespace EasyFCGI
         concept DumpingString = requires( T&& t ) {
             { t.dump() } -> std::same_as<std::string>;
         };
+
+        // reflected aggregates, or types described by glz::meta
+        template<typename T>
+        concept GlazeSerializable = glz::detail::glaze_t<std::remove_cvref_t<T>> || glz::detail::reflectable<std::remove_cvref_t<T>>;
     }
 
+    struct Request;
+
+    // receives the content of one multipart file part chunk by chunk as it arrives,
+    // followed by one empty chunk at the end of the part
+    using UploadSink = std::function<void( StrView Chunk )>;
+
     struct Config
     {
         // evetually capped by /proc/sys/net/core/somaxconncat,eg.4096
@@ -640,6 +1031,70 @@ namespace EasyFCGI
         }();
 
         inline static std::function<void( int )> ClientSpaceSignalHandler{};
+
+        // consulted for every multipart file part before its content arrives
+        // a returned sink takes the content instead of Request::Files, which then only records name and type
+        inline static std::function<UploadSink( const Request&, StrView FieldName, StrView FileName, StrView ContentType )> UploadRouter{};
+
+        // multipart/form-data is read from stdin in chunks of this size,
+        // a delimiter line or part header block beyond MultipartHeaderLimit ends parsing
+        constexpr static auto MultipartChunkSize = 64 * 1024uz;
+        constexpr static auto MultipartHeaderLimit = 16 * 1024uz;
+
+        // file parts growing beyond the threshold move from Payload to an unnamed file in UploadSpillDirectory
+        constexpr static auto UploadSpillThreshold = 256 * 1024uz;
+        inline static auto UploadSpillDirectory = FS::temp_directory_path();
+
+        // request body stays on the socket until Query / Files / Body<T>() is first used, or read through Request::Stream()
+        // handlers rejecting by header answer without ever pulling it, unread stdin is dropped by the connection
+        inline static auto LazyRequestBody = false;
+
+        // number of worker threads used by Server::Run() when not specified
+        inline static auto DefaultWorkerCount = std::max( std::thread::hardware_concurrency(), 1u );
+
+        // epoll events harvested per epoll_wait(), extra ready connections are parked in EventLoop::ReadyConnections
+        constexpr static auto EventBatchSize = 64;
+        constexpr static auto ReadyConnectionCapacity = 1024uz;
+        constexpr static auto CacheLineSize = 64uz;
+
+        // initial buffer of the per-worker request arena, grows from the heap beyond that
+        constexpr static auto RequestArenaSize = 64 * 1024uz;
+
+        // response bytes buffered before being wrapped into STDOUT records
+        constexpr static auto OutputBufferSize = 16 * 1024uz;
+
+        // Response::Body copies into chunks of this size, recycled per worker thread up to the pool size
+        // strings handed over by move from the adopt size on are linked in as they are
+        constexpr static auto BodyChunkSize = 16 * 1024uz;
+        constexpr static auto BodyChunkPoolSize = 64uz;
+        constexpr static auto BodyAdoptSize = 4 * 1024uz;
+
+        // content of a STDOUT record carrying Response::SendFile data, whole pages of the page cache
+        constexpr static auto SendFileRecordSize = 60 * 1024uz;
+
+        // a response write waiting this long for room in the socket send buffer fails its connection
+        constexpr static auto SendTimeoutMilliseconds = 30000;
+
+        // accept several interleaved requests on one upstream connection
+        inline static auto MultiplexConnections = true;
+
+        // enforced per process on accept and BEGIN_REQUEST, derived from worker count in Server::Run() when not specified
+        // advertised as FCGI_MAX_CONNS / FCGI_MAX_REQS multiplied by the process count under Server::RunPreFork()
+        inline static auto MaxConnections = std::optional<std::size_t>{};
+        inline static auto MaxRequests = std::optional<std::size_t>{};
+        constexpr static auto ConnectionsPerWorker = 8uz;
+        constexpr static auto RequestsPerWorker = 4uz;
+
+        // frames queued for one SSEHub subscriber before it is dropped as too slow
+        // idle subscribers are checked for aborts and dead connections once per sweep
+        constexpr static auto SSEQueueLimit = 256uz;
+        constexpr static auto SSESweepMilliseconds = 1000;
+
+        // Server::RunPreFork() restarts a worker process at once if it ran for at least ProcessStableMilliseconds,
+        // otherwise, or if fork() failed, after a delay doubling from the min up to the max
+        constexpr static auto ProcessStableMilliseconds = 5000;
+        constexpr static auto ProcessRestartMinMilliseconds = 100;
+        constexpr static auto ProcessRestartMaxMilliseconds = 10000;
     };
 
     struct ScopedTimer
@@ -681,46 +1136,40 @@ namespace EasyFCGI
     //     }
     // } TerminationToken{ TerminationSource.get_token() };
 
-    extern "C" void OS_LibShutdown();  // for omitting #include <fcgios.h>
+    // stays readable once stop is requested, waking up every thread polling on it
+    static auto TerminationFD = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    static auto TerminationWakeUp = std::stop_callback( TerminationToken, [] { (void)::eventfd_write( TerminationFD, 1 ); } );
+
     static auto ServerInitialization = [] {
         static auto ServerInitializationComplete = false;
         if( std::exchange( ServerInitializationComplete, true ) ) return;
 
-        if( auto ErrorCode = FCGX_Init(); ErrorCode == 0 )
-        {
-            std::println( "[ OK ]  ServerInitialization : FCGX_Init" );
-            std::atexit( OS_LibShutdown );
-            std::atexit( [] {
-                std::println(
-                    "Porgram exiting from standard exit pathway.\n"
-                    "Termination Signal : {}",
-                    TerminationToken.stop_requested() );
-            } );
-
-            struct sigaction SignalAction;
-            sigemptyset( &SignalAction.sa_mask );
-            SignalAction.sa_flags = 0;  // disable SA_RESTART
-            SignalAction.sa_handler = []( int Signal ) {
-                TerminationSource.request_stop();
-                FCGX_ShutdownPending();
-                std::println( "\nReceiving Signal : {}", Signal );
-                if( Config::ClientSpaceSignalHandler ) Config::ClientSpaceSignalHandler( Signal );
-            };
-            ::sigaction( SIGINT, &SignalAction, nullptr );
-            ::sigaction( SIGTERM, &SignalAction, nullptr );
+        std::println( "[ OK ]  ServerInitialization" );
+        std::atexit( [] {
+            std::println(
+                "Porgram exiting from standard exit pathway.\n"
+                "Termination Signal : {}",
+                TerminationToken.stop_requested() );
+        } );
+
+        struct sigaction SignalAction;
+        sigemptyset( &SignalAction.sa_mask );
+        SignalAction.sa_flags = 0;  // disable SA_RESTART
+        SignalAction.sa_handler = []( int Signal ) {
+            TerminationSource.request_stop();
+            std::println( "\nReceiving Signal : {}", Signal );
+            if( Config::ClientSpaceSignalHandler ) Config::ClientSpaceSignalHandler( Signal );
+        };
+        ::sigaction( SIGINT, &SignalAction, nullptr );
+        ::sigaction( SIGTERM, &SignalAction, nullptr );
 
-            // sigemptyset( &SignalAction.sa_mask );
-            // SignalAction.sa_handler = SIG_IGN;
-            // ::sigaction( SIGPIPE, &SignalAction, nullptr );
-        }
-        else
-        {
-            std::println( "[ Fatal, Error = {} ]  ServerInitialization : FCGX_Init NOT Successful", ErrorCode );
-            std::exit( ErrorCode );
-        }
+        // upstream closing a connection must not kill the process
+        sigemptyset( &SignalAction.sa_mask );
+        SignalAction.sa_handler = SIG_IGN;
+        ::sigaction( SIGPIPE, &SignalAction, nullptr );
     };
 
-    using SocketFileDescriptor = decltype( FCGX_OpenSocket( {}, {} ) );
+    using SocketFileDescriptor = int;
     using ConnectionFileDescriptor = decltype( ::accept( {}, {}, {} ) );
 
     static auto PollFor( int FD, unsigned int Flags, int Timeout = -1 )
@@ -729,197 +1178,1576 @@ namespace EasyFCGI
         return ::poll( &PollFD, 1, Timeout ) > 0 && ( PollFD.revents & Flags ) == Flags;
     }
 
-    struct ReusableFD
+    // waits for FD, false once termination is requested or Timeout ran out
+    // a signal interrupts only the thread receiving it, the others are woken through TerminationFD
+    // hangup and error count as ready, the following call on FD reports them
+    static auto PollUntilTerminated( int FD, unsigned int Flags, int Timeout = -1 )
     {
-        ReusableFD()
+        pollfd PollFDs[] = { { .fd = FD, .events = static_cast<short>( Flags ), .revents = 0 },
+                             { .fd = TerminationFD, .events = POLLIN, .revents = 0 } };
+        while( ! TerminationToken.stop_requested() )
         {
-            if( ::pipe( PipeFD ) != 0 )
-            {
-                std::println( "Fail to create PendingFD Pipe" );
-                std::exit( 0 );
-            }
+            auto Ready = ::poll( PollFDs, 2, Timeout );
+            if( Ready == 0 ) return false;
+            if( Ready > 0 && PollFDs[0].revents != 0 ) return true;
         }
-        ~ReusableFD()
+        return false;
+    }
+
+    // bounded lock-free multi-producer multi-consumer queue (Vyukov)
+    template<typename T, std::size_t Capacity>
+    requires( std::has_single_bit( Capacity ) )
+    struct MPMCRing
+    {
+        struct Cell
+        {
+            std::atomic<std::size_t> Sequence;
+            T Data;
+        };
+
+        std::array<Cell, Capacity> Cells;
+        alignas( Config::CacheLineSize ) std::atomic<std::size_t> EnqueuePos{ 0 };
+        alignas( Config::CacheLineSize ) std::atomic<std::size_t> DequeuePos{ 0 };
+
+        MPMCRing()
         {
-            ::close( PipeFD[0] );
-            ::close( PipeFD[1] );
+            for( auto Index = 0uz; Index < Capacity; ++Index ) Cells[Index].Sequence.store( Index, std::memory_order_relaxed );
         }
-        mutable std::mutex PipeLock;
-        int PipeFD[2];
+        MPMCRing( const MPMCRing& ) = delete;
 
-        auto Store( ConnectionFileDescriptor FD ) const
+        auto TryPush( T Value ) -> bool
         {
-            auto _ = std::lock_guard{ PipeLock };
-            return ::write( PipeFD[1], &FD, sizeof( FD ) );
+            auto Pos = EnqueuePos.load( std::memory_order_relaxed );
+            while( true )
+            {
+                auto& Target = Cells[Pos & ( Capacity - 1 )];
+                auto Lag = static_cast<std::ptrdiff_t>( Target.Sequence.load( std::memory_order_acquire ) - Pos );
+                if( Lag == 0 )
+                {
+                    if( EnqueuePos.compare_exchange_weak( Pos, Pos + 1, std::memory_order_relaxed ) )
+                    {
+                        Target.Data = std::move( Value );
+                        Target.Sequence.store( Pos + 1, std::memory_order_release );
+                        return true;
+                    }
+                }
+                else if( Lag < 0 ) return false;  // full
+                else Pos = EnqueuePos.load( std::memory_order_relaxed );
+            }
         }
-        auto Load() const -> std::optional<ConnectionFileDescriptor>
+
+        auto TryPop() -> std::optional<T>
         {
-            auto _ = std::lock_guard{ PipeLock };
-            if( PollFor( PipeFD[0], POLLIN, 0 ) )
+            auto Pos = DequeuePos.load( std::memory_order_relaxed );
+            while( true )
             {
-                auto FD = ConnectionFileDescriptor{};
-                if( ::read( PipeFD[0], &FD, sizeof( FD ) ) >= 0 ) return FD;
+                auto& Target = Cells[Pos & ( Capacity - 1 )];
+                auto Lag = static_cast<std::ptrdiff_t>( Target.Sequence.load( std::memory_order_acquire ) - ( Pos + 1 ) );
+                if( Lag == 0 )
+                {
+                    if( DequeuePos.compare_exchange_weak( Pos, Pos + 1, std::memory_order_relaxed ) )
+                    {
+                        auto Value = std::move( Target.Data );
+                        Target.Sequence.store( Pos + Capacity, std::memory_order_release );
+                        return Value;
+                    }
+                }
+                else if( Lag < 0 ) return std::nullopt;  // empty
+                else Pos = DequeuePos.load( std::memory_order_relaxed );
             }
-            return std::nullopt;
         }
-        auto empty() const { return ! PollFor( PipeFD[0], POLLIN, 0 ); }
+
+        // approximate under contention
+        auto empty() const { return EnqueuePos.load( std::memory_order_relaxed ) == DequeuePos.load( std::memory_order_relaxed ); }
     };
 
-    struct Response
+    // FCGI envirnoment variables set up by upstream server, in arrival order
+    using ParamList = std::vector<std::pair<StrView, StrView>>;
+
+    // open addressing table over a ParamList, built once when the params of a request are complete
+    // HTTP_* names compare with '-' as '_' and case ignored, so header lookups need neither formatting nor allocation
+    // other CGI variables, SCRIPT_NAME and the like, compare exactly
+    // lists too long for the table fall back to scanning
+    struct ParamIndex
     {
-        HTTP::StatusCode StatusCode{ HTTP::StatusCode::OK };
-        HTTP::ContentType ContentType{ HTTP::Content::Text::Plain };
-        std::map<std::string, std::string> Header;
-        std::map<std::string, std::string> Cookie;
-        std::string Body;
+        constexpr static auto Capacity = 256uz;  // nginx sends 30-60 params, load stays below half
+        constexpr static auto Mask = Capacity - 1;
 
-        [[maybe_unused]] decltype( auto ) Set( HTTP::StatusCode NewValue ) { return StatusCode = NewValue, *this; }
-        [[maybe_unused]] decltype( auto ) Set( HTTP::ContentType NewValue ) { return ContentType = NewValue, *this; }
-        [[maybe_unused]] decltype( auto ) SetHeader( const std::string& Key, auto&& Value )
+        const ParamList* Params{ nullptr };
+        std::array<std::uint16_t, Capacity> Slots{};  // position in Params + 1, 0 for empty
+
+        static constexpr auto Normalize( char C ) -> char
         {
-            Header[Key] = std::forward<decltype( Value )>( Value );
-            return *this;
+            if( C == '-' ) return '_';
+            return C >= 'a' && C <= 'z' ? static_cast<char>( C - 'a' + 'A' ) : C;
         }
-        [[maybe_unused]] decltype( auto ) SetCookie( const std::string& Key, auto&& Value )
+
+        // FNV-1a over the normalized name, equal for names equal under either comparison
+        static constexpr auto Hash( StrView Prefix, StrView Name ) -> std::size_t
         {
-            Cookie[Key] = std::forward<decltype( Value )>( Value );
-            return *this;
+            auto Result = 0x811C9DC5u;
+            for( auto C : Prefix ) Result = ( Result ^ static_cast<unsigned char>( Normalize( C ) ) ) * 0x01000193u;
+            for( auto C : Name ) Result = ( Result ^ static_cast<unsigned char>( Normalize( C ) ) ) * 0x01000193u;
+            return Result;
         }
-        [[maybe_unused]] decltype( auto ) Reset()
+
+        static constexpr auto Matches( StrView Key, StrView Prefix, StrView Name ) -> bool
         {
-            Set( HTTP::StatusCode::OK );
-            Set( HTTP::Content::Text::Plain );
-            Header.clear();
-            Cookie.clear();
-            Body.clear();
-            return *this;
+            if( Key.size() != Prefix.size() + Name.size() ) return false;
+            if( ! Key.starts_with( "HTTP_" ) ) return Key.starts_with( Prefix ) && Key.substr( Prefix.size() ) == Name;
+            auto Equal = []( char L, char R ) { return Normalize( L ) == Normalize( R ); };
+            return RNG::equal( Key.substr( 0, Prefix.size() ), Prefix, Equal ) && RNG::equal( Key.substr( Prefix.size() ), Name, Equal );
         }
 
-        template<typename T>  //requires( ! std::same_as<std::remove_cvref_t<T>, Response> )
-        [[maybe_unused]] decltype( auto ) operator=( T&& NewContent )
+        auto Build( const ParamList& Source ) -> void
         {
-            if constexpr( DumpingString<T> ) { Body = std::forward<T>( NewContent ).dump(); }
-            else { Body = std::forward<T>( NewContent ); }
-            return *this;
+            Params = &Source;
+            Slots.fill( 0 );
+            if( Source.size() > Capacity / 2 ) return;
+            for( auto Position = 0uz; Position < Source.size(); ++Position )
+            {
+                auto Name = Source[Position].first;
+                auto Probe = Hash( {}, Name ) & Mask;
+                for( ; Slots[Probe] != 0; Probe = ( Probe + 1 ) & Mask )
+                    if( Matches( Source[Slots[Probe] - 1].first, {}, Name ) ) break;
+                if( Slots[Probe] == 0 ) Slots[Probe] = static_cast<std::uint16_t>( Position + 1 );  // first one wins
+            }
         }
 
-        template<typename T>  //
-        [[maybe_unused]] decltype( auto ) Append( T&& NewContent )
+        // Prefix + Name, "HTTP_" + "User-Agent" finds HTTP_USER_AGENT
+        auto Find( StrView Prefix, StrView Name ) const -> StrView
         {
-            if( Body.empty() ) return operator=( std::forward<T>( NewContent ) );
-            if constexpr( DumpingString<T> ) { Body.append( NewContent.dump() ); }
-            else { Body.append( std::forward<T>( NewContent ) ); }
-            return *this;
+            if( Params == nullptr ) return {};
+            if( Params->size() > Capacity / 2 )
+            {
+                for( auto&& [Key, Value] : *Params )
+                    if( Matches( Key, Prefix, Name ) ) return Value;
+                return {};
+            }
+            for( auto Probe = Hash( Prefix, Name ) & Mask; Slots[Probe] != 0; Probe = ( Probe + 1 ) & Mask )
+                if( auto&& [Key, Value] = ( *Params )[Slots[Probe] - 1]; Matches( Key, Prefix, Name ) ) return Value;
+            return {};
         }
 
-        template<typename T>                                            //
-        [[maybe_unused]] decltype( auto ) operator+=( T&& NewContent )  //
+        auto Find( StrView Name ) const -> StrView { return Find( {}, Name ); }
+    };
+
+    // live connections and requests against the caps advertised to upstream
+    struct ConcurrencyLimit
+    {
+        std::size_t MaxConnections{ 1 };
+        std::size_t MaxRequests{ 1 };
+        std::size_t ProcessCount{ 1 };  // processes sharing the listen socket
+        std::atomic<std::size_t> Connections{ 0 };
+        std::atomic<std::size_t> Requests{ 0 };
+        std::atomic<bool> AcceptPaused{ false };
+        std::function<void()> ResumeAccept{};  // invoked when a connection is released while accept is paused
+
+        auto Configure( std::size_t WorkerCount )
+        {
+            WorkerCount = std::max( WorkerCount, 1uz );
+            MaxConnections = std::max( Config::MaxConnections.value_or( WorkerCount * Config::ConnectionsPerWorker ), 1uz );
+            MaxRequests = std::max( Config::MaxRequests.value_or( WorkerCount * Config::RequestsPerWorker ), 1uz );
+            if( ! Config::MultiplexConnections ) MaxRequests = std::min( MaxRequests, MaxConnections );
+        }
+
+        static auto TryAcquire( std::atomic<std::size_t>& Counter, std::size_t Max )
         {
-            return Append( std::forward<T>( NewContent ) );
+            auto Current = Counter.load();
+            while( Current < Max )
+                if( Counter.compare_exchange_weak( Current, Current + 1 ) ) return true;
+            return false;
+        }
+
+        // upstream sees one listen socket, the advertised limits cover every process behind it
+        auto AdvertisedConnections() const { return MaxConnections * ProcessCount; }
+        auto AdvertisedRequests() const { return MaxRequests * ProcessCount; }
+
+        auto TryAcquireConnection() { return TryAcquire( Connections, MaxConnections ); }
+        auto TryAcquireRequest() { return TryAcquire( Requests, MaxRequests ); }
+
+        auto ReleaseConnection()
+        {
+            --Connections;
+            if( AcceptPaused && ResumeAccept ) ResumeAccept();
         }
+        auto ReleaseRequest() { --Requests; }
     };
 
-    struct Request
+    // one upstream connection, possibly carrying several interleaved requests
+    // every string_view handed out for a request points into its Slot
+    //
+    // reading is serialized by ReadLock, whoever holds it routes records to every Slot
+    // writing is serialized by WriteLock, one request writes whole records at a time
+    // records a write that must not wait could not finish are left in Backlog, ahead of any later output
+    // the connection is armed in EventLoop only while no request expects more stdin,
+    // otherwise the handler reading its stdin routes records of the others
+    struct Connection : std::enable_shared_from_this<Connection>
     {
-        struct Query
+        using RecordType = FastCGI::RecordType;
+
+        struct Record
         {
-            EasyFCGI::Json Json;
-            auto contains( StrView Key ) const { return Json.contains( Key ); }
-            auto CountRepeated( StrView Key ) const -> decltype( Json.size() )
+            FastCGI::RecordHeader Header;
+            StrView Content;
+        };
+
+        // state of one request on this connection
+        struct Slot
+        {
+            std::uint16_t RequestID;
+            std::atomic<bool> ParamsComplete{ false };
+            std::atomic<bool> StdinClosed{ false };
+            std::atomic<bool> StdinAbandoned{ false };  // body will not be read, remaining stdin records are dropped
+            std::atomic<bool> Aborted{ false };
+            std::string ParamBuffer;
+            ParamList Params;
+            ParamIndex Index;
+            std::string EntryText;  // Params rendered as NAME=VALUE, see Request::AllHeaderEntries
+            std::string StdinBuffer;  // routed by other readers
+            std::size_t StdinPos{ 0 };
+            StrView StdinChunk;  // direct view into InBuffer, only while holding ReadLock
+            std::string OutBuffer;
+            ConcurrencyLimit* Limit;
+
+            explicit Slot( std::uint16_t RequestID, ConcurrencyLimit* Limit = nullptr ) : RequestID{ RequestID }, Limit{ Limit }
             {
-                if( ! Json.contains( Key ) ) return 0;
-                return Json[Key].size();
+                OutBuffer.reserve( Config::OutputBufferSize );
             }
-            auto operator[]( StrView Key, std::size_t Index = 0 ) const -> std::string
+            Slot( const Slot& ) = delete;
+            ~Slot()
             {
-                if( ! Json.contains( Key ) ) return {};
-                const auto& Slot = Json[Key];
-                if( Slot.is_array() )
-                {
-                    if( Index < Slot.size() )
-                        return Slot[Index];
-                    else
-                        return {};
-                }
-                if( Slot.is_string() ) return Slot.template get<std::string>();
-                return Slot.dump();
+                if( Limit ) Limit->ReleaseRequest();
             }
         };
+        using SlotList = std::vector<std::shared_ptr<Slot>>;
 
-        struct Cookie
+        enum class ReadMode : unsigned char { BufferedOnly, NonBlocking, Blocking };
+
+        ConnectionFileDescriptor FD;
+        std::vector<char> InBuffer = std::vector<char>( FastCGI::MaxRecordLength );
+        std::size_t ReadPos{ 0 };
+        std::size_t WritePos{ 0 };
+        std::atomic<int> LastError{ 0 };
+        std::atomic<bool> KeepConnection{ false };
+
+        std::mutex ReadLock;
+        std::mutex WriteLock;
+        std::string Backlog;  // tail of records cut short by a write that would not wait, goes out before anything else
+        mutable std::mutex SlotLock;
+        std::map<std::uint16_t, std::shared_ptr<Slot>> Slots;
+
+        // EventLoop bookkeeping, keeps the connection alive while armed in epoll
+        std::atomic<bool> Armed{ false };
+        std::atomic<std::shared_ptr<Connection>> Anchor;
+
+        // already counted by the acceptor, released on destruction
+        ConcurrencyLimit* Limit;
+
+        explicit Connection( ConnectionFileDescriptor FD, ConcurrencyLimit* Limit = nullptr ) : FD{ FD }, Limit{ Limit } {}
+        Connection( const Connection& ) = delete;
+        ~Connection()
         {
-            FCGX_ParamArray EnvPtr;
-            auto operator[]( StrView Key ) const -> StrView
-            {
-                if( EnvPtr == nullptr ) return {};
-                using namespace ParseUtil;
-                auto CookieField = FCGX_GetParam( "HTTP_COOKIE", EnvPtr );
-                if( CookieField == nullptr ) return {};
-                for( auto Entry : CookieField | SplitBy( ';' ) )
-                    for( auto [K, V] : Entry | SplitOnceBy( '=' ) | VIEW::transform( TrimSpace ) | VIEW::pairwise )
-                        if( K == Key ) return V;
-                return {};
-            }
-        };
+            if( FD != -1 ) ::close( FD );
+            if( Limit ) Limit->ReleaseConnection();
+        }
 
-        struct Header
+        auto Alive() const { return LastError.load( std::memory_order_relaxed ) == 0; }
+
+        // room in the socket send buffer right now
+        auto Writable() const { return PollFor( FD, POLLOUT, 0 ); }
+
+        auto Fail( int ErrorCode )
         {
-            FCGX_ParamArray EnvPtr;
-            auto operator[]( StrView Key ) const -> StrView
+            LastError = ErrorCode;
+            KeepConnection = false;
+            return false;
+        }
+
+        // room in the socket send buffer within Config::SendTimeoutMilliseconds, caller holds WriteLock
+        // a stalled or vanished upstream fails the connection rather than keep WriteLock forever
+        auto WaitWritable() -> bool
+        {
+            if( PollUntilTerminated( FD, POLLOUT, Config::SendTimeoutMilliseconds ) ) return true;
+            return Fail( TerminationToken.stop_requested() ? EINTR : ETIMEDOUT );
+        }
+
+        // ensure at least N unread bytes in InBuffer, N <= FastCGI::MaxRecordLength
+        auto Receive( std::size_t N, ReadMode Mode ) -> bool
+        {
+            if( ReadPos == WritePos ) ReadPos = WritePos = 0;
+            while( WritePos - ReadPos < N )
             {
-                if( EnvPtr == nullptr ) return {};
-                auto FullHeaderKey = "HTTP_{}"_FMT( Key );
-                for( auto& C : FullHeaderKey )
+                if( Mode == ReadMode::BufferedOnly || ! Alive() ) return false;
+                if( InBuffer.size() - ReadPos < N )
                 {
-                    if( C == '-' ) C = '_';
-                    C = std::toupper( C );
+                    std::memmove( InBuffer.data(), InBuffer.data() + ReadPos, WritePos - ReadPos );
+                    WritePos -= std::exchange( ReadPos, 0 );
                 }
-                auto Result = FCGX_GetParam( FullHeaderKey.c_str(), EnvPtr );
-                if( Result == nullptr ) return {};
-                return Result;
+                auto Received = ::read( FD, InBuffer.data() + WritePos, InBuffer.size() - WritePos );
+                if( Received > 0 ) { WritePos += Received; }
+                else if( Received == 0 ) { return Fail( ECONNRESET ); }
+                else if( errno == EAGAIN && Mode == ReadMode::Blocking )
+                {
+                    if( ! PollUntilTerminated( FD, POLLIN ) ) return Fail( EINTR );
+                }
+                else if( errno == EAGAIN ) { return false; }
+                else if( errno == EINTR && ! TerminationToken.stop_requested() ) { continue; }
+                else { return Fail( errno ); }
             }
-        };
+            return true;
+        }
 
-        struct Files
+        // Record.Content stays valid until the next call, caller holds ReadLock
+        auto NextRecord( ReadMode Mode ) -> std::optional<Record>
         {
-            enum class OverWriteOptions : unsigned char { Abort, OverWrite, RenameOldFile, RenameNewFile };
+            if( ! Receive( FastCGI::HeaderLength, Mode ) ) return std::nullopt;
+            auto Header = FastCGI::RecordHeader::Decode( InBuffer.data() + ReadPos );
+            if( Header.Version != FastCGI::Version ) return Fail( EPROTO ), std::nullopt;
+            if( ! Receive( Header.RecordLength(), Mode ) ) return std::nullopt;
+            auto Content = StrView{ InBuffer.data() + ReadPos + FastCGI::HeaderLength, Header.ContentLength };
+            ReadPos += Header.RecordLength();
+            return Record{ Header, Content };
+        }
 
-            struct FileView
+        // from the front of Vectors until all is sent or the socket is full, Vectors left at what remains
+        // caller holds WriteLock
+        auto WriteSome( std::span<iovec>& Vectors ) -> bool
+        {
+            while( ! Vectors.empty() )
             {
-                using enum OverWriteOptions;
-                StrView FileName;
-                StrView ContentType;
-                StrView ContentBody;
-
-                static auto NewFilePath( const FS::path& Path ) -> FS::path
+                if( ! Alive() ) return false;
+                auto Sent = ::writev( FD, Vectors.data(), static_cast<int>( std::min<std::size_t>( Vectors.size(), IOV_MAX ) ) );
+                if( Sent == -1 )
                 {
-                    auto ResultPath = Path;
-                    auto FileExtension = Path.extension().string();
-                    auto OriginalStem = Path.stem().string();
-                    do {
-                        auto TimeStampSuffix = ".{:%Y.%m.%d.%H.%M.%S}"_FMT( std::chrono::file_clock::now() );
-                        auto NewFileName = "{}{}{}"_FMT( OriginalStem, StrView{ TimeStampSuffix }.substr( 0, 24 ), FileExtension );
-                        ResultPath.replace_filename( NewFileName );
-                    } while( FS::exists( ResultPath ) );
-                    return ResultPath;
+                    if( errno == EAGAIN ) return true;
+                    if( errno != EINTR ) return Fail( errno );
+                    continue;
                 }
-
-                auto SaveAs( const FS::path& Path, const OverWriteOptions OverWriteOption = OverWriteOptions::Abort ) const -> std::optional<FS::path>
+                for( auto Remain = static_cast<std::size_t>( Sent ); Remain > 0 || ( ! Vectors.empty() && Vectors.front().iov_len == 0 ); )
                 {
-                    auto ParentDir = Path.parent_path();
-                    if( ! FS::exists( ParentDir ) ) FS::create_directories( ParentDir );
-
-                    auto ResultPath = Path;
-                    if( FS::exists( ResultPath ) )  //
-                        switch( OverWriteOption )
+                    auto& Front = Vectors.front();
+                    if( Remain < Front.iov_len )
+                    {
+                        Front.iov_base = static_cast<char*>( Front.iov_base ) + Remain;
+                        Front.iov_len -= Remain;
+                        break;
+                    }
+                    Remain -= Front.iov_len;
+                    Vectors = Vectors.subspan( 1 );
+                }
+            }
+            return true;
+        }
+
+        // Backlog without waiting, true once it is empty, caller holds WriteLock
+        auto FlushBacklog() -> bool
+        {
+            if( Backlog.empty() ) return Alive();
+            auto Whole = iovec{ Backlog.data(), Backlog.size() };
+            auto Unsent = std::span{ &Whole, 1 };
+            if( ! WriteSome( Unsent ) ) return false;
+            Backlog.erase( 0, Backlog.size() - ( Unsent.empty() ? 0 : Unsent.front().iov_len ) );
+            return Backlog.empty();
+        }
+
+        // Backlog, then Vectors, waiting for room as needed, caller holds WriteLock
+        auto Transmit( std::span<iovec> Vectors ) -> bool
+        {
+            while( ! FlushBacklog() )
+                if( ! Alive() || ! WaitWritable() ) return false;
+            while( ! Vectors.empty() )
+                if( ! WriteSome( Vectors ) || ( ! Vectors.empty() && ! WaitWritable() ) ) return false;
+            return true;
+        }
+
+        // as much of Vectors as the socket takes right now, the rest is copied to Backlog
+        // caller holds WriteLock and has emptied Backlog
+        auto TransmitNow( std::span<iovec> Vectors ) -> bool
+        {
+            if( ! WriteSome( Vectors ) ) return false;
+            for( auto& Vector : Vectors ) Backlog.append( static_cast<const char*>( Vector.iov_base ), Vector.iov_len );
+            return true;
+        }
+
+        // WriteLock for a write that must not wait, owned only if it was free and Backlog went out
+        auto TryHoldWriter() -> std::unique_lock<std::mutex>
+        {
+            auto Hold = std::unique_lock{ WriteLock, std::try_to_lock };
+            if( Hold && ! FlushBacklog() ) Hold.unlock();
+            return Hold;
+        }
+
+        auto SendRecord( FastCGI::RecordType Type, std::uint16_t ID, StrView Content ) -> bool
+        {
+            auto Header = FastCGI::EncodeHeader( Type, ID, Content.size() );
+            iovec Vectors[]{ { Header.data(), Header.size() }, { const_cast<char*>( Content.data() ), Content.size() } };
+            auto _ = std::lock_guard{ WriteLock };
+            return Transmit( Vectors );
+        }
+
+        auto SendEndRequest( std::uint16_t ID, FastCGI::ProtocolStatus Status ) -> bool
+        {
+            auto Body = FastCGI::EncodeEndRequestBody( 0, Status );
+            return SendRecord( RecordType::EndRequest, ID, { Body.data(), Body.size() } );
+        }
+
+        // wrap OutBuffer and then the borrowed Segments into STDOUT records,
+        // optionally closing the stream and ending the request, handed to Send as one iovec list
+        // records span segment boundaries, segments are never copied
+        auto EncodeOutput( Slot& Target, std::span<const StrView> Segments, bool EndOfRequest, auto&& Send ) -> bool
+        {
+            auto Total = Target.OutBuffer.size();
+            for( auto Segment : Segments ) Total += Segment.size();
+            if( Total == 0 && ! EndOfRequest ) return Alive();
+            auto RecordCount = ( Total + FastCGI::MaxContentLength - 1 ) / FastCGI::MaxContentLength;
+            // lists of typical responses fit on the stack, only large or many-segment ones reach the heap
+            auto StackBuffer = std::array<std::byte, 1024>{};
+            auto StackResource = std::pmr::monotonic_buffer_resource{ StackBuffer.data(), StackBuffer.size() };
+            auto Headers = std::pmr::vector<FastCGI::RawHeader>{ &StackResource };
+            auto Vectors = std::pmr::vector<iovec>{ &StackResource };
+            Headers.reserve( RecordCount + 2 );
+            Vectors.reserve( RecordCount * 2 + Segments.size() + 4 );
+
+            auto Piece = StrView{ Target.OutBuffer };
+            auto NextSegment = Segments.begin();
+            for( auto Remain = Total; Remain > 0; )
+            {
+                auto Length = std::min( Remain, FastCGI::MaxContentLength );
+                auto& Header = Headers.emplace_back( FastCGI::EncodeHeader( RecordType::Stdout, Target.RequestID, Length ) );
+                Vectors.push_back( { Header.data(), Header.size() } );
+                for( Remain -= Length; Length > 0; Length -= Vectors.back().iov_len )
+                {
+                    while( Piece.empty() ) Piece = *NextSegment++;
+                    auto Chunk = Piece.substr( 0, Length );
+                    Piece.remove_prefix( Chunk.size() );
+                    Vectors.push_back( { const_cast<char*>( Chunk.data() ), Chunk.size() } );
+                }
+            }
+            auto EndBody = FastCGI::EncodeEndRequestBody( 0, FastCGI::ProtocolStatus::RequestComplete );
+            if( EndOfRequest )
+            {
+                auto& StdoutEnd = Headers.emplace_back( FastCGI::EncodeHeader( RecordType::Stdout, Target.RequestID, 0 ) );
+                auto& EndHeader = Headers.emplace_back( FastCGI::EncodeHeader( RecordType::EndRequest, Target.RequestID, EndBody.size() ) );
+                Vectors.push_back( { StdoutEnd.data(), StdoutEnd.size() } );
+                Vectors.push_back( { EndHeader.data(), EndHeader.size() } );
+                Vectors.push_back( { EndBody.data(), EndBody.size() } );
+            }
+            auto Sent = Send( std::span{ Vectors } );
+            Target.OutBuffer.clear();
+            return Sent;
+        }
+
+        // in one writev, waiting for room as needed
+        auto FlushOutput( Slot& Target, std::span<const StrView> Segments, bool EndOfRequest = false ) -> bool
+        {
+            return EncodeOutput( Target, Segments, EndOfRequest, [this]( std::span<iovec> Vectors ) {
+                auto _ = std::lock_guard{ WriteLock };
+                return Transmit( Vectors );
+            } );
+        }
+
+        // without waiting, what the socket does not take right now goes to Backlog, caller holds TryHoldWriter()
+        auto FlushOutputNow( Slot& Target, std::span<const StrView> Segments ) -> bool
+        {
+            return EncodeOutput( Target, Segments, false, [this]( std::span<iovec> Vectors ) { return TransmitNow( Vectors ); } );
+        }
+
+        auto FlushOutput( Slot& Target, bool EndOfRequest = false ) -> bool { return FlushOutput( Target, {}, EndOfRequest ); }
+
+        // pending OutBuffer, then Length bytes of FileFD from Offset as STDOUT records
+        // record header written, then its content handed from page cache to the socket by sendfile,
+        // under one WriteLock hold, records of other requests interleave in between
+        auto SendFile( Slot& Target, int FileFD, std::size_t Offset, std::size_t Length ) -> bool
+        {
+            if( ! FlushOutput( Target ) ) return false;
+            for( auto Position = static_cast<off_t>( Offset ); Length > 0; )
+            {
+                auto RecordLength = std::min( Length, Config::SendFileRecordSize );
+                auto Header = FastCGI::EncodeHeader( RecordType::Stdout, Target.RequestID, RecordLength );
+                auto HeaderVector = iovec{ Header.data(), Header.size() };
+                auto _ = std::lock_guard{ WriteLock };
+                if( ! Transmit( { &HeaderVector, 1 } ) ) return false;
+                for( auto Remain = RecordLength; Remain > 0; )
+                {
+                    if( ! Alive() ) return false;
+                    auto Sent = ::sendfile( FD, FileFD, &Position, Remain );
+                    if( Sent == 0 ) return Fail( EIO );  // file shrank, the record cannot be completed
+                    if( Sent == -1 )
+                    {
+                        if( errno == EAGAIN ) { if( ! WaitWritable() ) return false; }
+                        else if( errno != EINTR ) return Fail( errno );
+                        continue;
+                    }
+                    Remain -= static_cast<std::size_t>( Sent );
+                }
+                Length -= RecordLength;
+            }
+            return true;
+        }
+
+        auto HandleManagementRecord( const Record& ManagementRecord )
+        {
+            namespace MV = FastCGI::ManagementVariable;
+            if( ManagementRecord.Header.Type != RecordType::GetValues )
+            {
+                auto Body = FastCGI::EncodeUnknownTypeBody( ManagementRecord.Header.Type );
+                return SendRecord( RecordType::UnknownType, FastCGI::NullRequestID, { Body.data(), Body.size() } );
+            }
+            auto MaxConnections = std::to_string( Limit ? Limit->AdvertisedConnections() : 1 );
+            auto MaxRequests = std::to_string( Limit ? Limit->AdvertisedRequests() : 1 );
+            auto Result = std::string{};
+            for( auto Query = ManagementRecord.Content; auto Pair = FastCGI::DecodeNameValuePair( Query ); )
+            {
+                if( Pair->first == MV::MaxConnections ) FastCGI::EncodeNameValuePair( Result, MV::MaxConnections, MaxConnections );
+                if( Pair->first == MV::MaxRequests ) FastCGI::EncodeNameValuePair( Result, MV::MaxRequests, MaxRequests );
+                if( Pair->first == MV::MultiplexConnections )
+                    FastCGI::EncodeNameValuePair( Result, MV::MultiplexConnections, Config::MultiplexConnections ? "1" : "0" );
+            }
+            return SendRecord( RecordType::GetValuesResult, FastCGI::NullRequestID, Result );
+        }
+
+        auto FindSlot( std::uint16_t RequestID ) const -> std::shared_ptr<Slot>
+        {
+            auto _ = std::lock_guard{ SlotLock };
+            if( auto Target = Slots.find( RequestID ); Target != Slots.end() ) return Target->second;
+            return nullptr;
+        }
+
+        // some request will read the socket by itself later
+        auto ExpectingStdin() const
+        {
+            auto _ = std::lock_guard{ SlotLock };
+            return RNG::any_of( Slots, []( auto&& Entry ) {
+                auto& Target = *Entry.second;
+                return Target.ParamsComplete && ! Target.StdinClosed && ! Target.StdinAbandoned;
+            } );
+        }
+
+        // caller holds ReadLock, requests whose PARAMS stream completed are appended to Completed
+        // records of finished or aborted requests are discarded
+        auto Route( const Record& Incoming, SlotList& Completed ) -> void
+        {
+            auto [Header, Content] = Incoming;
+            if( Header.RequestID == FastCGI::NullRequestID )
+            {
+                HandleManagementRecord( Incoming );
+                return;
+            }
+
+            auto Target = FindSlot( Header.RequestID );
+            switch( Header.Type )
+            {
+                default : break;
+                case RecordType::BeginRequest :
+                {
+                    auto [Role, Flags] = FastCGI::BeginRequestBody::Decode( Content );
+                    auto Rejection = std::optional<FastCGI::ProtocolStatus>{};
+                    if( Target ) break;
+                    if( Role != FastCGI::Role::Responder ) Rejection = FastCGI::ProtocolStatus::UnknownRole;
+                    {
+                        auto _ = std::lock_guard{ SlotLock };
+                        if( ! Rejection && ! Config::MultiplexConnections && ! Slots.empty() ) Rejection = FastCGI::ProtocolStatus::CantMultiplexConnection;
+                        if( ! Rejection && Limit && ! Limit->TryAcquireRequest() ) Rejection = FastCGI::ProtocolStatus::Overloaded;
+                        if( ! Rejection ) Slots.emplace( Header.RequestID, std::make_shared<Slot>( Header.RequestID, Limit ) );
+                    }
+                    if( Rejection ) SendEndRequest( Header.RequestID, *Rejection );
+                    else KeepConnection = Flags & FastCGI::KeepConnectionFlag;
+                    break;
+                }
+                case RecordType::AbortRequest :
+                {
+                    if( ! Target ) break;
+                    Target->StdinClosed = true;
+                    Target->Aborted = true;
+                    if( Target->ParamsComplete ) break;  // handler sees end of stdin, finishes as usual
+                    {
+                        auto _ = std::lock_guard{ SlotLock };
+                        Slots.erase( Header.RequestID );
+                    }
+                    SendEndRequest( Header.RequestID, FastCGI::ProtocolStatus::RequestComplete );
+                    break;
+                }
+                case RecordType::Params :
+                {
+                    if( ! Target || Target->ParamsComplete ) break;
+                    if( ! Content.empty() )
+                    {
+                        Target->ParamBuffer.append( Content );
+                        break;
+                    }
+                    // ParamBuffer no longer grows, safe to take views
+                    for( auto Remain = StrView{ Target->ParamBuffer }; auto Pair = FastCGI::DecodeNameValuePair( Remain ); ) Target->Params.push_back( *Pair );
+                    Target->Index.Build( Target->Params );
+                    Target->ParamsComplete = true;
+                    Completed.push_back( std::move( Target ) );
+                    break;
+                }
+                case RecordType::Stdin :
+                {
+                    if( ! Target || Target->StdinClosed ) break;
+                    if( Content.empty() ) Target->StdinClosed = true;
+                    else if( ! Target->StdinAbandoned ) Target->StdinBuffer.append( Content );
+                    break;
+                }
+            }
+        }
+
+        // nonblocking, route every complete record available
+        // returns empty if another thread is reading, it will re-arm the connection afterwards
+        auto Pump() -> SlotList
+        {
+            auto Completed = SlotList{};
+            auto Lock = std::unique_lock{ ReadLock, std::try_to_lock };
+            if( ! Lock ) return Completed;
+            while( auto Incoming = NextRecord( ReadMode::NonBlocking ) ) Route( *Incoming, Completed );
+            return Completed;
+        }
+
+        // equivalent of FCGX_GetStr, returns bytes copied, less than N only at end of stdin
+        // reads the socket by itself, routing records of other requests on the way
+        auto ReceiveStdin( Slot& Target, char* Buffer, std::size_t N, SlotList& Completed ) -> std::size_t
+        {
+            auto _ = std::lock_guard{ ReadLock };
+            auto Copied = 0uz;
+            while( Copied < N )
+            {
+                if( Target.StdinPos < Target.StdinBuffer.size() )
+                {
+                    auto Length = StrView{ Target.StdinBuffer }.substr( Target.StdinPos ).copy( Buffer + Copied, N - Copied );
+                    Target.StdinPos += Length;
+                    Copied += Length;
+                    continue;
+                }
+                Target.StdinBuffer.clear();
+                Target.StdinPos = 0;
+
+                if( ! Target.StdinChunk.empty() )
+                {
+                    auto Length = Target.StdinChunk.copy( Buffer + Copied, N - Copied );
+                    Target.StdinChunk.remove_prefix( Length );
+                    Copied += Length;
+                    continue;
+                }
+
+                if( Target.StdinClosed || Target.StdinAbandoned ) break;
+                auto Incoming = NextRecord( ReadMode::Blocking );
+                if( ! Incoming )
+                {
+                    Target.StdinClosed = true;
+                    break;
+                }
+                if( Incoming->Header.RequestID == Target.RequestID && Incoming->Header.Type == RecordType::Stdin )
+                    Target.StdinClosed = ( Target.StdinChunk = Incoming->Content ).empty();
+                else
+                    Route( *Incoming, Completed );
+            }
+
+            // views into InBuffer do not survive other readers
+            Target.StdinBuffer.append( std::exchange( Target.StdinChunk, {} ) );
+            while( auto Incoming = NextRecord( ReadMode::BufferedOnly ) ) Route( *Incoming, Completed );
+            return Copied;
+        }
+
+        // returns true if the connection should stay open
+        auto EndRequest( Slot& Target, std::span<const StrView> Segments = {} ) -> bool
+        {
+            auto Sent = FlushOutput( Target, Segments, true );
+            auto _ = std::lock_guard{ SlotLock };
+            Slots.erase( Target.RequestID );
+            if( Sent && KeepConnection ) return true;
+            if( Slots.empty() ) ::shutdown( FD, SHUT_RDWR );
+            return false;
+        }
+    };
+
+    // unix domain socket path, or [ipv4]:port for tcp
+    static auto OpenListenSocket( const FS::path& SocketPath, int BackLog ) -> SocketFileDescriptor
+    {
+        auto Address = StrView{ SocketPath.native() };
+        auto FD = SocketFileDescriptor{ -1 };
+        auto BindAndListen = [&]( const auto& SocketAddress ) {
+            if( FD != -1 &&  //
+                ::bind( FD, reinterpret_cast<const sockaddr*>( &SocketAddress ), sizeof( SocketAddress ) ) == 0 &&
+                ::listen( FD, BackLog ) == 0 )
+                return FD;
+            if( FD != -1 ) ::close( FD );
+            return SocketFileDescriptor{ -1 };
+        };
+
+        if( auto Colon = Address.rfind( ':' ); Colon != StrView::npos && ! Address.contains( '/' ) )
+        {
+            auto Host = std::string{ Address.substr( 0, Colon ) };
+            auto Port = Address.substr( Colon + 1 ) | ParseUtil::ConvertTo<std::uint16_t>;
+            auto SocketAddress = sockaddr_in{ .sin_family = AF_INET, .sin_port = htons( Port.value_or( 0 ) ), .sin_addr = { htonl( INADDR_ANY ) }, .sin_zero = {} };
+            if( ! Port || ( ! Host.empty() && ::inet_pton( AF_INET, Host.c_str(), &SocketAddress.sin_addr ) != 1 ) ) return -1;
+            FD = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+            auto Enable = 1;
+            ::setsockopt( FD, SOL_SOCKET, SO_REUSEADDR, &Enable, sizeof( Enable ) );
+            return BindAndListen( SocketAddress );
+        }
+
+        auto SocketAddress = sockaddr_un{ .sun_family = AF_UNIX, .sun_path = {} };
+        if( Address.size() >= sizeof( SocketAddress.sun_path ) ) return -1;
+        Address.copy( SocketAddress.sun_path, Address.size() );
+        ::unlink( SocketAddress.sun_path );
+        FD = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        return BindAndListen( SocketAddress );
+    }
+
+    // single epoll instance shared by all workers, watching
+    // listen socket, termination eventfd and every idle connection at once
+    struct EventLoop
+    {
+        enum class EventSource : unsigned char { Interrupted, Termination, NewConnection, KeptAliveConnection, PendingRequest };
+        struct Event
+        {
+            EventSource Source{ EventSource::Interrupted };
+            std::shared_ptr<Connection> Conn{};
+            std::shared_ptr<Connection::Slot> Slot{};
+        };
+
+        int EpollFD{ -1 };
+        SocketFileDescriptor ListenSocket;
+
+        // listen socket leaves the epoll set while MaxConnections are open,
+        // further connections wait in the kernel backlog, upstream sees it and paces itself
+        // declared first, outlives the connections still queued below
+        ConcurrencyLimit Limit;
+        std::mutex AcceptLock;
+
+        // connections already reported readable by epoll, not yet picked up by any worker
+        // popped without touching the kernel
+        MPMCRing<std::shared_ptr<Connection>, Config::ReadyConnectionCapacity> ReadyConnections;
+
+        // multiplexed requests completed by one worker, to be served by the others
+        std::mutex PendingLock;
+        std::deque<std::pair<std::shared_ptr<Connection>, std::shared_ptr<Connection::Slot>>> PendingRequests;
+        std::atomic<std::size_t> PendingCount{ 0 };
+
+        // edge-triggered, each write wakes one more worker to drain ReadyConnections
+        int PeerWakeUpFD{ -1 };
+
+        EventLoop( SocketFileDescriptor SourceSocketFD ) : ListenSocket{ SourceSocketFD }
+        {
+            Open();
+            Limit.Configure( Config::DefaultWorkerCount );
+            Limit.ResumeAccept = [this] { UpdateAccept(); };
+        }
+
+        auto Open() -> void
+        {
+            EpollFD = ::epoll_create1( EPOLL_CLOEXEC );
+            PeerWakeUpFD = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+            if( EpollFD == -1 || PeerWakeUpFD == -1 )
+            {
+                std::println( "Fail to create epoll instance" );
+                std::exit( 0 );
+            }
+            // level-triggered, every waiting worker observes termination
+            Watch( ListenSocket, EPOLLIN );
+            Watch( TerminationFD, EPOLLIN );
+            Watch( PeerWakeUpFD, EPOLLIN | EPOLLET );
+        }
+
+        // a forked child must not share epoll instance or eventfd with its parent,
+        // readiness of a connection would be reported to a process not owning it
+        auto Reopen() -> void
+        {
+            ::close( EpollFD );
+            ::close( PeerWakeUpFD );
+            Limit.AcceptPaused = false;
+            Open();
+        }
+        EventLoop( const EventLoop& ) = delete;
+        ~EventLoop()
+        {
+            ::close( EpollFD );
+            ::close( PeerWakeUpFD );
+        }
+
+        // internal fds are tagged with their own address, connections with the Connection object
+        auto Watch( const int& FD, std::uint32_t Events ) const -> int
+        {
+            auto Event = epoll_event{ .events = Events, .data = { .ptr = const_cast<int*>( &FD ) } };
+            return ::epoll_ctl( EpollFD, EPOLL_CTL_ADD, FD, &Event );
+        }
+
+        // idle connection sits in the epoll set until upstream sends more records
+        // EPOLLONESHOT hands one readable connection to exactly one worker
+        // the epoll set keeps the connection alive through Anchor while armed
+        auto Store( std::shared_ptr<Connection> Conn )
+        {
+            if( ! Conn->Alive() || Conn->Armed.exchange( true ) ) return 0;
+            auto Raw = Conn.get();
+            Raw->Anchor.store( std::move( Conn ) );
+            auto Event = epoll_event{ .events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, .data = { .ptr = Raw } };
+            if( ::epoll_ctl( EpollFD, EPOLL_CTL_MOD, Raw->FD, &Event ) == 0 ) return 0;
+            if( ::epoll_ctl( EpollFD, EPOLL_CTL_ADD, Raw->FD, &Event ) == 0 ) return 0;
+            Raw->Armed = false;
+            Raw->Anchor.store( nullptr );
+            return -1;
+        }
+
+        auto WakeUpPeer() const { (void)::eventfd_write( PeerWakeUpFD, 1 ); }
+
+        // pause or resume accepting according to the current connection count
+        auto UpdateAccept() -> void
+        {
+            auto _ = std::lock_guard{ AcceptLock };
+            auto Paused = Limit.Connections >= Limit.MaxConnections;
+            if( Paused == Limit.AcceptPaused ) return;
+            auto Event = epoll_event{ .events = Paused ? 0u : EPOLLIN, .data = { .ptr = &ListenSocket } };
+            if( ::epoll_ctl( EpollFD, EPOLL_CTL_MOD, ListenSocket, &Event ) == 0 ) Limit.AcceptPaused = Paused;
+        }
+
+        // hand completed requests of one connection to other workers
+        auto Dispatch( const std::shared_ptr<Connection>& Conn, Connection::SlotList Completed )
+        {
+            if( Completed.empty() ) return;
+            {
+                auto _ = std::lock_guard{ PendingLock };
+                for( auto&& Slot : Completed ) PendingRequests.emplace_back( Conn, std::move( Slot ) );
+                PendingCount = PendingRequests.size();
+            }
+            for( auto _ : Completed ) WakeUpPeer();
+        }
+
+        auto TakePending() -> Event
+        {
+            auto _ = std::lock_guard{ PendingLock };
+            if( PendingRequests.empty() ) return {};
+            auto [Conn, Slot] = std::move( PendingRequests.front() );
+            PendingRequests.pop_front();
+            PendingCount = PendingRequests.size();
+            return { EventSource::PendingRequest, std::move( Conn ), std::move( Slot ) };
+        }
+
+        auto Wait( int Timeout = -1 ) -> Event
+        {
+            using enum EventSource;
+            auto ReadyEvents = std::array<epoll_event, Config::EventBatchSize>{};
+            while( true )
+            {
+                if( PendingCount > 0 )
+                    if( auto Pending = TakePending(); Pending.Slot ) return Pending;
+
+                if( auto KeptAlive = ReadyConnections.TryPop() )
+                {
+                    if( ! ReadyConnections.empty() ) WakeUpPeer();
+                    return { KeptAliveConnection, std::move( *KeptAlive ) };
+                }
+
+                auto ReadyCount = ::epoll_wait( EpollFD, ReadyEvents.data(), ReadyEvents.size(), Timeout );
+                if( ReadyCount <= 0 ) return {};
+
+                auto Harvest = [this]( Connection* Raw, std::uint32_t Events ) {
+                    auto KeptAlive = Raw->Anchor.exchange( nullptr );
+                    Raw->Armed = false;
+                    if( ! KeptAlive ) return;
+                    // upstream closed the connection, last owner releases it
+                    // marked failed so an SSE subscriber still holding it is swept, not kept until the next publish
+                    if( ( Events & ( EPOLLHUP | EPOLLERR ) ) || ! ( Events & EPOLLIN ) )
+                    {
+                        KeptAlive->Fail( ECONNRESET );
+                        return;
+                    }
+                    if( ! ReadyConnections.TryPush( KeptAlive ) )
+                        Store( std::move( KeptAlive ) );  // ring saturated, leave it to epoll
+                };
+
+                auto TerminationRequested = false;
+                auto ListenSocketReady = false;
+                for( auto&& ReadyEvent : ReadyEvents | VIEW::take( ReadyCount ) )
+                {
+                    auto Tag = ReadyEvent.data.ptr;
+                    if( Tag == &TerminationFD ) TerminationRequested = true;
+                    else if( Tag == &ListenSocket ) ListenSocketReady = true;
+                    else if( Tag == &PeerWakeUpFD ) continue;
+                    else Harvest( static_cast<Connection*>( Tag ), ReadyEvent.events );
+                }
+
+                if( TerminationRequested ) return { Termination };
+                if( ListenSocketReady )
+                {
+                    if( ! ReadyConnections.empty() ) WakeUpPeer();
+                    return { NewConnection };
+                }
+            }
+        }
+    };
+
+    // per-worker monotonic arena backing request-lifetime containers
+    // released, not freed, when the worker starts a request and no earlier request object still uses it
+    struct RequestArena
+    {
+        std::array<std::byte, Config::RequestArenaSize> InitialBuffer;
+        std::pmr::monotonic_buffer_resource Resource{ InitialBuffer.data(), InitialBuffer.size() };
+        std::atomic<std::size_t> Users{ 0 };
+
+        // held by every request object built on the arena
+        // like pmr containers, a lease is copied on construction and never re-targeted by assignment
+        struct Lease
+        {
+            RequestArena* Arena{ nullptr };
+
+            Lease() = default;
+            explicit Lease( RequestArena* Arena ) : Arena{ Arena }
+            {
+                if( Arena ) ++Arena->Users;
+            }
+            Lease( const Lease& Other ) : Lease( Other.Arena ) {}
+            Lease& operator=( const Lease& ) { return *this; }
+            ~Lease()
+            {
+                if( Arena ) --Arena->Users;
+            }
+
+            auto Resource() const -> std::pmr::memory_resource* { return Arena ? &Arena->Resource : std::pmr::get_default_resource(); }
+        };
+
+        // only the owning worker takes new leases, Users can only drop to 0 behind its back
+        // request objects kept beyond their turn leave later requests on the heap until released
+        static auto Acquire() -> Lease
+        {
+            thread_local struct WorkerArena
+            {
+                RequestArena* Arena = new RequestArena;
+                ~WorkerArena()
+                {
+                    if( Arena->Users == 0 ) delete Arena;  // otherwise outlived by request objects, leaked
+                }
+            } Worker;
+
+            if( Worker.Arena->Users != 0 ) return {};
+            Worker.Arena->Resource.release();
+            return Lease{ Worker.Arena };
+        }
+    };
+
+    // header lines rendered once, for handlers sending the same set on every response
+    // referred to by Response::Use(), must outlive the responses using it
+    struct HeaderSet
+    {
+        std::string Block;
+
+        HeaderSet( std::initializer_list<std::pair<StrView, StrView>> Lines )
+        {
+            for( auto [Key, Value] : Lines ) Block.append( Key ).append( ": " ).append( Value ).append( "\r\n" );
+        }
+    };
+
+    // response body as a list of segments, written content never moves while more is appended
+    // segments point into chunks owned here, strings adopted by move, or borrowed static content
+    // handed to Connection::FlushOutput as they are
+    struct SegmentedBody
+    {
+        using Chunk = std::unique_ptr<char[]>;
+
+        std::pmr::vector<StrView> Segments;
+        std::pmr::vector<Chunk> Chunks;
+        std::pmr::deque<std::string> Adopted;
+        std::size_t TailRoom{ 0 };  // unused bytes at the end of Chunks.back()
+        std::size_t Size{ 0 };
+
+        SegmentedBody() = default;
+        explicit SegmentedBody( std::pmr::memory_resource* Arena ) : Segments{ Arena }, Chunks{ Arena }, Adopted{ Arena } {}
+        SegmentedBody( SegmentedBody&& ) = default;
+        SegmentedBody& operator=( SegmentedBody&& ) = default;
+        ~SegmentedBody() { clear(); }
+
+        static auto Pool() -> std::vector<Chunk>&
+        {
+            thread_local auto FreeChunks = std::vector<Chunk>{};
+            return FreeChunks;
+        }
+
+        auto empty() const { return Size == 0; }
+        auto size() const { return Size; }
+
+        auto clear() -> void
+        {
+            auto& FreeChunks = Pool();
+            for( auto& Released : Chunks )
+                if( FreeChunks.size() < Config::BodyChunkPoolSize ) FreeChunks.push_back( std::move( Released ) );
+            Chunks.clear();
+            Segments.clear();
+            Adopted.clear();
+            TailRoom = 0;
+            Size = 0;
+        }
+
+        auto Append( StrView Text )
+        {
+            Size += Text.size();
+            while( ! Text.empty() )
+            {
+                if( TailRoom == 0 )
+                {
+                    auto& FreeChunks = Pool();
+                    if( FreeChunks.empty() ) Chunks.push_back( std::make_unique_for_overwrite<char[]>( Config::BodyChunkSize ) );
+                    else
+                    {
+                        Chunks.push_back( std::move( FreeChunks.back() ) );
+                        FreeChunks.pop_back();
+                    }
+                    TailRoom = Config::BodyChunkSize;
+                }
+                auto Cursor = Chunks.back().get() + Config::BodyChunkSize - TailRoom;
+                auto Length = Text.copy( Cursor, TailRoom );
+                Text.remove_prefix( Length );
+                TailRoom -= Length;
+                // grows the last segment while it still ends at the cursor
+                if( ! Segments.empty() && Segments.back().data() + Segments.back().size() == Cursor )
+                    Segments.back() = { Segments.back().data(), Segments.back().size() + Length };
+                else Segments.emplace_back( Cursor, Length );
+            }
+        }
+
+        // rvalue std::string only, literals and char pointers stay on the StrView overload
+        template<std::same_as<std::string> S>
+        auto Append( S&& Text )
+        {
+            if( Text.size() < Config::BodyAdoptSize ) return Append( StrView{ Text } );
+            Size += Text.size();
+            Segments.emplace_back( Adopted.emplace_back( std::move( Text ) ) );
+        }
+
+        auto Append( char C ) { Append( StrView{ &C, 1 } ); }
+
+        // content outliving the response, string literals and the like
+        auto Borrow( StrView Static )
+        {
+            if( Static.empty() ) return;
+            Size += Static.size();
+            Segments.push_back( Static );
+        }
+
+        // copied out in one piece, for the rare consumer wanting contiguous text
+        auto str() const
+        {
+            auto Result = std::string{};
+            Result.reserve( Size );
+            for( auto Segment : Segments ) Result.append( Segment );
+            return Result;
+        }
+    };
+
+    struct Response
+    {
+        using StringMap = std::pmr::map<std::pmr::string, std::pmr::string, std::less<>>;
+
+        HTTP::StatusCode StatusCode{ HTTP::StatusCode::OK };
+        HTTP::ContentType ContentType{ HTTP::Content::Text::Plain };
+        StringMap Header;
+        StringMap Cookie;
+        const HeaderSet* Preset{ nullptr };
+        SegmentedBody Body;
+
+        // file sent in place of Body, moved from page cache to socket by sendfile when the request finishes
+        struct FileBody
+        {
+            int FD;
+            std::size_t Offset, Length;
+            explicit FileBody( int FD, std::size_t Offset, std::size_t Length ) : FD{ FD }, Offset{ Offset }, Length{ Length } {}
+            FileBody( const FileBody& ) = delete;
+            ~FileBody() { ::close( FD ); }
+        };
+        std::shared_ptr<FileBody> File;
+
+        Response() = default;
+        explicit Response( std::pmr::memory_resource* Arena ) : Header{ Arena }, Cookie{ Arena }, Body{ Arena } {}
+
+        [[maybe_unused]] decltype( auto ) Set( HTTP::StatusCode NewValue ) { return StatusCode = NewValue, *this; }
+        [[maybe_unused]] decltype( auto ) Set( HTTP::ContentType NewValue ) { return ContentType = NewValue, *this; }
+        [[maybe_unused]] decltype( auto ) SetHeader( StrView Key, auto&& Value )
+        {
+            Header[std::pmr::string{ Key, Header.get_allocator() }] = std::forward<decltype( Value )>( Value );
+            return *this;
+        }
+        [[maybe_unused]] decltype( auto ) SetCookie( StrView Key, auto&& Value )
+        {
+            Cookie[std::pmr::string{ Key, Cookie.get_allocator() }] = std::forward<decltype( Value )>( Value );
+            return *this;
+        }
+        [[maybe_unused]] decltype( auto ) Use( const HeaderSet& Headers ) { return Preset = &Headers, *this; }
+        [[maybe_unused]] decltype( auto ) Borrow( StrView Static ) { return Body.Borrow( Static ), *this; }
+        [[maybe_unused]] decltype( auto ) Reset()
+        {
+            Set( HTTP::StatusCode::OK );
+            Set( HTTP::Content::Text::Plain );
+            Header.clear();
+            Cookie.clear();
+            Preset = nullptr;
+            Body.clear();
+            File.reset();
+            return *this;
+        }
+
+        // Length bytes from Offset, clamped to the file, Range of the request is applied on top
+        // false if the file cannot be opened, the response is left as it was
+        auto SendFile( const FS::path& Path, std::size_t Offset = 0, std::size_t Length = -1uz ) -> bool
+        {
+            auto FD = ::open( Path.c_str(), O_RDONLY | O_CLOEXEC );
+            if( FD == -1 ) return false;
+            struct stat Status{};
+            if( ::fstat( FD, &Status ) == -1 || ! S_ISREG( Status.st_mode ) )
+            {
+                ::close( FD );
+                return false;
+            }
+            auto FileSize = static_cast<std::size_t>( Status.st_size );
+            Offset = std::min( Offset, FileSize );
+            File = std::make_shared<FileBody>( FD, Offset, std::min( Length, FileSize - Offset ) );
+            Body.clear();
+            return true;
+        }
+
+        template<typename T>  //requires( ! std::same_as<std::remove_cvref_t<T>, Response> )
+        [[maybe_unused]] decltype( auto ) operator=( T&& NewContent )
+        {
+            Body.clear();
+            return Append( std::forward<T>( NewContent ) );
+        }
+
+        template<typename T>  //
+        [[maybe_unused]] decltype( auto ) Append( T&& NewContent )
+        {
+            if constexpr( DumpingString<T> ) { Body.Append( NewContent.dump() ); }
+            else if constexpr( GlazeSerializable<T> )
+            {
+                // serialized over a per-thread scratch string, copied into pooled chunks unless large enough to adopt
+                thread_local auto Scratch = std::string{};
+                glz::write<glz::opts{}>( NewContent, Scratch );
+                if( Scratch.size() < Config::BodyAdoptSize ) Body.Append( StrView{ Scratch } );
+                else Body.Append( std::exchange( Scratch, {} ) );
+            }
+            else { Body.Append( std::forward<T>( NewContent ) ); }
+            return *this;
+        }
+
+        template<typename T>                                            //
+        [[maybe_unused]] decltype( auto ) operator+=( T&& NewContent )  //
+        {
+            return Append( std::forward<T>( NewContent ) );
+        }
+    };
+
+    // upload content written to an unnamed file as it arrives, SaveAs links it into place
+    // O_TMPFILE in Config::UploadSpillDirectory, memfd where the filesystem lacks support
+    struct SpillFile
+    {
+        int FD;
+        std::size_t Size{ 0 };
+        bool Intact{ true };
+
+        explicit SpillFile( int FD ) : FD{ FD } {}
+        SpillFile( const SpillFile& ) = delete;
+        ~SpillFile() { ::close( FD ); }
+
+        static auto Create() -> std::shared_ptr<SpillFile>
+        {
+            auto FD = ::open( Config::UploadSpillDirectory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0644 );
+            if( FD == -1 ) FD = ::memfd_create( "EasyFCGI-Upload", MFD_CLOEXEC );
+            if( FD == -1 ) return nullptr;
+            return std::make_shared<SpillFile>( FD );
+        }
+
+        auto Write( StrView Chunk ) -> bool
+        {
+            while( Intact && ! Chunk.empty() )
+            {
+                auto Written = ::write( FD, Chunk.data(), Chunk.size() );
+                if( Written > 0 )
+                {
+                    Chunk.remove_prefix( Written );
+                    Size += Written;
+                }
+                else if( errno != EINTR ) Intact = false;
+            }
+            return Intact;
+        }
+
+        // in-kernel copy when the target is on another filesystem, sendfile where copy_file_range refuses
+        auto CopyTo( int TargetFD ) const -> bool
+        {
+            auto Offset = loff_t{ 0 };
+            while( static_cast<std::size_t>( Offset ) < Size )
+            {
+                auto Copied = ::copy_file_range( FD, &Offset, TargetFD, nullptr, Size - Offset, 0 );
+                if( Copied > 0 ) continue;
+                if( Copied == -1 && errno == EINTR ) continue;
+                break;
+            }
+            for( auto SendOffset = static_cast<off_t>( Offset ); static_cast<std::size_t>( SendOffset ) < Size; )
+            {
+                auto Sent = ::sendfile( TargetFD, FD, &SendOffset, Size - SendOffset );
+                if( Sent == 0 || ( Sent == -1 && errno != EINTR ) ) return false;
+            }
+            return true;
+        }
+
+        // target must not exist
+        auto SaveAs( const FS::path& Target ) const -> bool
+        {
+            if( ! Intact ) return false;
+            auto ProcPath = "/proc/self/fd/{}"_FMT( FD );
+            if( ::linkat( AT_FDCWD, ProcPath.c_str(), AT_FDCWD, Target.c_str(), AT_SYMLINK_FOLLOW ) == 0 ) return true;
+            auto TargetFD = ::open( Target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644 );
+            if( TargetFD == -1 ) return false;
+            auto Copied = CopyTo( TargetFD );
+            ::close( TargetFD );
+            if( ! Copied ) ::unlink( Target.c_str() );
+            return Copied;
+        }
+    };
+
+    // incremental multipart/form-data parser, fed with stdin chunks as they arrive
+    // per part: OnPart( HeaderBlock ) once, OnContent( Chunk ) any number of times, OnPartEnd() once
+    // only a possible partial delimiter is carried over between chunks
+    struct MultipartParser
+    {
+        enum class State : unsigned char { Preamble, AfterDelimiter, Headers, Content, Done };
+
+        std::string Delimiter;
+        std::string Window;
+        State Current{ State::Preamble };
+
+        // leading CRLF lets the first boundary match Delimiter as well
+        explicit MultipartParser( StrView Boundary ) : Delimiter{ "\r\n--{}"_FMT( Boundary ) }, Window{ "\r\n" } {}
+
+        auto Done() const { return Current == State::Done; }
+
+        auto Feed( StrView Chunk, auto&& OnPart, auto&& OnContent, auto&& OnPartEnd ) -> void
+        {
+            using enum State;
+            Window.append( Chunk );
+            auto Input = StrView{ Window };
+            auto Progressing = true;
+            while( Progressing ) switch( Current )
+                {
+                    case Preamble :
+                    case Content :
+                    {
+                        auto Match = Input.find( Delimiter );
+                        auto Available = Match != StrView::npos ? Match : Input.size() - std::min( Input.size(), Delimiter.size() - 1 );
+                        if( Current == Content && Available > 0 ) OnContent( Input.substr( 0, Available ) );
+                        Input.remove_prefix( Available );
+                        if( Match == StrView::npos )
+                        {
+                            Progressing = false;
+                            break;
+                        }
+                        if( Current == Content ) OnPartEnd();
+                        Input.remove_prefix( Delimiter.size() );
+                        Current = AfterDelimiter;
+                        break;
+                    }
+                    case AfterDelimiter :
+                    {
+                        if( Input.starts_with( "--" ) )
+                        {
+                            Current = Done;
+                            break;
+                        }
+                        // transport padding may precede CRLF
+                        auto LineEnd = Input.find( "\r\n" );
+                        if( LineEnd == StrView::npos )
+                        {
+                            if( Input.size() > Config::MultipartHeaderLimit ) Current = Done;
+                            else Progressing = false;
+                            break;
+                        }
+                        Input.remove_prefix( LineEnd + 2 );
+                        Current = Headers;
+                        break;
+                    }
+                    case Headers :
+                    {
+                        // CRLF right after the delimiter line is an empty header block
+                        auto HeaderEnd = Input.starts_with( "\r\n" ) ? 0 : Input.find( "\r\n\r\n" );
+                        if( HeaderEnd == StrView::npos )
+                        {
+                            if( Input.size() > Config::MultipartHeaderLimit ) Current = Done;
+                            else Progressing = false;
+                            break;
+                        }
+                        OnPart( Input.substr( 0, HeaderEnd ) );
+                        Input.remove_prefix( HeaderEnd + ( HeaderEnd == 0 ? 2 : 4 ) );
+                        Current = Content;
+                        break;
+                    }
+                    case Done :
+                    {
+                        Input = {};
+                        Progressing = false;
+                        break;
+                    }
+                }
+            Window.erase( 0, Window.size() - Input.size() );
+        }
+    };
+
+    struct Request final
+    {
+        // flat index of query string and form fields, in arrival order, repeated keys kept
+        // keys and values are views into request params, Payload, DecodeBuffer or the json body
+        // json tree is only built when asked for
+        struct Query
+        {
+            using Entry = std::pair<StrView, StrView>;
+            // json body is indexed on first lookup, typed handlers reading Request::Body<T>() never pay for it
+            mutable std::pmr::vector<Entry> Entries;
+            std::pmr::string DecodeBuffer;                           // reserved upfront, never reallocates while indexing
+            mutable std::pmr::deque<std::pmr::string> Materialized;  // non-string values of json body
+            mutable std::optional<EasyFCGI::Json> JsonCache;
+            mutable StrView PendingJsonBody;
+            mutable std::size_t TreeEntriesBegin{ 0 };  // Entries from here on are indexed from JsonCache
+            mutable bool TreeEdited{ false };           // JsonCache handed out for writing, reindexed on next lookup
+            Request* Owner{ nullptr };                  // set while the body is unread, see Request::ReadBody
+
+            // json body as received, otherwise every key mapped to an array of its values
+            // built on first use, edits made through it are seen by later lookups
+            struct JsonTree
+            {
+                const Query* Owner{ nullptr };  // rebound by Request::Bind
+
+                auto Get() const -> const EasyFCGI::Json& { return Owner->Materialize(); }
+                auto Get() -> EasyFCGI::Json&
+                {
+                    auto& Tree = Owner->Materialize();
+                    Owner->TreeEdited = true;
+                    return Tree;
+                }
+
+                operator const EasyFCGI::Json&() const { return Get(); }
+                operator EasyFCGI::Json&() { return Get(); }
+                auto operator->() const { return &Get(); }
+                auto operator->() { return &Get(); }
+                auto operator*() const -> const EasyFCGI::Json& { return Get(); }
+                auto operator*() -> EasyFCGI::Json& { return Get(); }
+                auto operator=( EasyFCGI::Json NewTree ) -> EasyFCGI::Json& { return Get() = std::move( NewTree ); }
+
+                decltype( auto ) operator[]( auto&& Key ) const { return Get()[std::forward<decltype( Key )>( Key )]; }
+                decltype( auto ) operator[]( auto&& Key ) { return Get()[std::forward<decltype( Key )>( Key )]; }
+                auto contains( auto&& Key ) const { return Get().contains( std::forward<decltype( Key )>( Key ) ); }
+                auto dump( auto&&... Args ) const { return Get().dump( std::forward<decltype( Args )>( Args )... ); }
+                auto items() const { return Get().items(); }
+                auto items() { return Get().items(); }
+                auto begin() const { return Get().begin(); }
+                auto begin() { return Get().begin(); }
+                auto end() const { return Get().end(); }
+                auto end() { return Get().end(); }
+                auto size() const { return Get().size(); }
+                auto empty() const { return Get().empty(); }
+            } Json{ this };
+
+            Query() = default;
+            explicit Query( std::pmr::memory_resource* Arena ) : Entries{ Arena }, DecodeBuffer{ Arena }, Materialized{ Arena } {}
+
+            auto clear()
+            {
+                Entries.clear();
+                DecodeBuffer.clear();
+                Materialized.clear();
+                JsonCache.reset();
+                PendingJsonBody = {};
+                TreeEntriesBegin = 0;
+                TreeEdited = false;
+            }
+
+            // decoded text is never longer than its source
+            // stays beyond small string capacity, so views survive moving the request
+            auto Reserve( std::size_t EncodedLength ) { DecodeBuffer.reserve( std::max( EncodedLength, 32uz ) ); }
+
+            auto Decode( StrView Fragment ) -> StrView
+            {
+                if( ParseUtil::FindURLEscape( Fragment.data(), Fragment.data() + Fragment.size() ) == Fragment.data() + Fragment.size() ) return Fragment;
+                auto Start = DecodeBuffer.size();
+                (void)ParseUtil::DecodeURLFragment( Fragment, DecodeBuffer );
+                return StrView{ DecodeBuffer }.substr( Start );
+            }
+
+            auto Append( StrView Key, StrView Value ) const
+            {
+                if( ! Key.empty() ) Entries.emplace_back( Key, Value );
+            }
+
+            auto AppendDecoded( StrView EncodedKey, StrView EncodedValue ) { Append( Decode( EncodedKey ), Decode( EncodedValue ) ); }
+
+            auto DeferJson( StrView Body ) { PendingJsonBody = Body; }
+
+            auto Resolve() const
+            {
+                if( Owner ) Owner->ReadBody();
+                if( ! PendingJsonBody.empty() ) Index( EasyFCGI::Json::parse( std::exchange( PendingJsonBody, {} ), nullptr, false ) );
+                if( std::exchange( TreeEdited, false ) )
+                {
+                    Entries.resize( TreeEntriesBegin );
+                    Materialized.clear();
+                    IndexTree();
+                }
+            }
+
+            auto Index( EasyFCGI::Json&& Body ) const -> void
+            {
+                JsonCache.emplace( std::move( Body ) );
+                TreeEntriesBegin = Entries.size();
+                IndexTree();
+            }
+
+            // top level members of JsonCache, arrays spread into repeated keys
+            auto IndexTree() const -> void
+            {
+                auto& Source = *JsonCache;
+                if( ! Source.is_object() ) return;
+                auto ValueView = [this]( const EasyFCGI::Json& Value ) -> StrView {
+                    if( Value.is_string() ) return Value.get_ref<const std::string&>();
+                    return Materialized.emplace_back( Value.dump() );
+                };
+                for( auto&& [Key, Value] : Source.items() )
+                {
+                    if( ! Value.is_array() ) Append( Key, ValueView( Value ) );
+                    else
+                        for( auto&& Element : Value ) Append( Key, ValueView( Element ) );
+                }
+            }
+
+            auto contains( StrView Key ) const
+            {
+                Resolve();
+                return RNG::contains( Entries | VIEW::keys, Key );
+            }
+            auto CountRepeated( StrView Key ) const -> std::size_t
+            {
+                Resolve();
+                return RNG::count( Entries | VIEW::keys, Key );
+            }
+            auto operator[]( StrView Key, std::size_t Index = 0 ) const -> StrView
+            {
+                Resolve();
+                for( auto&& [K, V] : Entries )
+                    if( K == Key && Index-- == 0 ) return V;
+                return {};
+            }
+
+            // backs Json, see JsonTree
+            auto Materialize() const -> EasyFCGI::Json&
+            {
+                Resolve();
+                if( ! JsonCache )
+                {
+                    JsonCache.emplace( EasyFCGI::Json::object() );
+                    for( auto&& [K, V] : Entries ) ( *JsonCache )[K].push_back( V );
+                    TreeEntriesBegin = 0;
+                }
+                return *JsonCache;
+            }
+        };
+
+        // Cookie field split once on first use, views into request params in header order
+        struct Cookie
+        {
+            using Entry = std::pair<StrView, StrView>;
+            const ParamIndex* Index{ nullptr };
+            mutable std::pmr::vector<Entry> Entries;
+            mutable bool Parsed{ false };
+
+            Cookie() = default;
+            explicit Cookie( std::pmr::memory_resource* Arena ) : Entries{ Arena } {}
+            Cookie( Cookie&& Other ) noexcept
+                : Index{ std::exchange( Other.Index, nullptr ) }, Entries{ std::move( Other.Entries ) }, Parsed{ std::exchange( Other.Parsed, false ) }
+            {
+                Other.Entries.clear();
+            }
+
+            // params of another request, nothing cached from the previous one survives
+            auto Reset( const ParamIndex* NewIndex ) -> void
+            {
+                Index = NewIndex;
+                Entries.clear();
+                Parsed = false;
+            }
+
+            auto Resolve() const -> const std::pmr::vector<Entry>&
+            {
+                if( std::exchange( Parsed, true ) || Index == nullptr ) return Entries;
+                using namespace ParseUtil;
+                auto CookieField = Index->Find( "HTTP_COOKIE" );
+                for( auto Segment : CookieField | SplitBy( ';' ) )
+                    for( auto [K, V] : Segment | SplitOnceBy( '=' ) | VIEW::transform( TrimSpace ) | VIEW::pairwise )
+                        if( ! K.empty() ) Entries.emplace_back( K, V );
+                return Entries;
+            }
+
+            auto begin() const { return Resolve().begin(); }
+            auto end() const { return Resolve().end(); }
+            auto size() const { return Resolve().size(); }
+
+            auto operator[]( StrView Key ) const -> StrView
+            {
+                for( auto&& [K, V] : Resolve() )
+                    if( K == Key ) return V;
+                return {};
+            }
+            auto contains( StrView Key ) const { return RNG::contains( Resolve() | VIEW::keys, Key ); }
+        };
+
+        struct Header
+        {
+            const ParamIndex* Index;
+            auto operator[]( StrView Key ) const -> StrView
+            {
+                if( Index == nullptr ) return {};
+                return Index->Find( "HTTP_", Key );
+            }
+        };
+
+        struct Files
+        {
+            enum class OverWriteOptions : unsigned char { Abort, OverWrite, RenameOldFile, RenameNewFile };
+
+            struct FileView
+            {
+                using enum OverWriteOptions;
+                StrView FileName;
+                StrView ContentType;
+                StrView ContentBody;                // empty once spilled
+                std::shared_ptr<SpillFile> Spilled{};
+
+                auto size() const { return Spilled ? Spilled->Size : ContentBody.size(); }
+
+                static auto NewFilePath( const FS::path& Path ) -> FS::path
+                {
+                    auto ResultPath = Path;
+                    auto FileExtension = Path.extension().string();
+                    auto OriginalStem = Path.stem().string();
+                    do {
+                        auto TimeStampSuffix = ".{:%Y.%m.%d.%H.%M.%S}"_FMT( std::chrono::file_clock::now() );
+                        auto NewFileName = "{}{}{}"_FMT( OriginalStem, StrView{ TimeStampSuffix }.substr( 0, 24 ), FileExtension );
+                        ResultPath.replace_filename( NewFileName );
+                    } while( FS::exists( ResultPath ) );
+                    return ResultPath;
+                }
+
+                auto SaveAs( const FS::path& Path, const OverWriteOptions OverWriteOption = OverWriteOptions::Abort ) const -> std::optional<FS::path>
+                {
+                    auto ParentDir = Path.parent_path();
+                    if( ! FS::exists( ParentDir ) ) FS::create_directories( ParentDir );
+
+                    auto ResultPath = Path;
+                    if( FS::exists( ResultPath ) )  //
+                        switch( OverWriteOption )
                         {
                             using enum OverWriteOptions;
                             case Abort :         return std::nullopt;
-                            case OverWrite :     break;
+                            case OverWrite :     if( Spilled ) FS::remove( ResultPath ); break;
                             case RenameOldFile : FS::rename( Path, NewFilePath( Path ) ); break;
                             case RenameNewFile : ResultPath = NewFilePath( Path ); break;
                         }
 
+                    if( Spilled ) return Spilled->SaveAs( ResultPath ) ? std::optional{ ResultPath } : std::nullopt;
+
                     auto FileFD = fopen( ResultPath.c_str(), "wb" );
                     std::fwrite( ContentBody.data(), sizeof( 1 [ContentBody.data()] ), ContentBody.size(), FileFD );
                     std::fclose( FileFD );
@@ -928,9 +2756,20 @@ namespace EasyFCGI
                 };
             };
 
-            std::map<StrView, std::vector<FileView>> Storage;
+            std::pmr::map<StrView, std::pmr::vector<FileView>> Storage;  // complete once Resolve() is called
+            Request* Owner{ nullptr };
+
+            Files() = default;
+            explicit Files( std::pmr::memory_resource* Arena ) : Storage{ Arena } {}
+
+            auto Resolve() const
+            {
+                if( Owner ) Owner->ReadBody();
+            }
+
             auto operator[]( StrView Key, std::size_t Index = 0 ) const -> FileView
             {
+                Resolve();
                 if( ! Storage.contains( Key ) ) return {};
                 const auto& Slot = Storage.at( Key );
                 if( Index < Slot.size() ) return Slot[Index];
@@ -938,197 +2777,352 @@ namespace EasyFCGI
             }
         };
 
-        struct Response Response;  // elaborated-type-specifier, silencing -Wchanges-meaning
+        RequestArena::Lease Arena;  // declared first, outlives every container allocated from it
+        struct Response Response;   // elaborated-type-specifier, silencing -Wchanges-meaning
         struct Files Files;
         std::string Payload;
         struct Query Query;
         struct Header Header;
         struct Cookie Cookie;
-        std::unique_ptr<FCGX_Request> FCGX_Request_Ptr;
+        std::shared_ptr<Connection> Connection_Ptr;
+        std::shared_ptr<Connection::Slot> Slot_Ptr;
         HTTP::RequestMethod Method;
         HTTP::ContentType ContentType;
-        ReusableFD* ReusableFD_Ptr;
+        EventLoop* EventLoop_Ptr{ nullptr };
+
+        enum class BodyProgress : unsigned char { Unread, Streamed, Parsed, Abandoned };
+        BodyProgress Progress{ BodyProgress::Parsed };
 
         // Read FCGI envirnoment variables set up by upstream server
-        auto GetParam( StrView ParamName ) const -> StrView
-        {
-            if( auto Result = FCGX_GetParam( std::data( ParamName ), FCGX_Request_Ptr->envp ) ) return Result;
-            return {};
-        }
+        auto GetParam( StrView ParamName ) const -> StrView { return Slot_Ptr->Index.Find( ParamName ); }
 
-        auto AllHeaderEntries() const
+        // name / value views into the slot, no copies
+        auto AllParams() const -> const ParamList& { return Slot_Ptr->Params; }
+
+        // "NAME=VALUE" of every param as envp used to have them, text rendered on first call
+        auto AllHeaderEntries() const -> std::vector<std::string_view>
         {
+            auto& Params = Slot_Ptr->Params;
+            auto& Text = Slot_Ptr->EntryText;
+            if( Text.empty() )
+            {
+                auto Total = 0uz;
+                for( auto [Name, Value] : Params ) Total += Name.size() + 1 + Value.size();
+                Text.reserve( Total );
+                for( auto [Name, Value] : Params ) Text.append( Name ).append( 1, '=' ).append( Value );
+            }
             auto Result = std::vector<std::string_view>{};
-            Result.reserve( 100 );
-            for( auto EnvP = FCGX_Request_Ptr->envp; EnvP != nullptr && *EnvP != nullptr; ++EnvP ) { Result.push_back( *EnvP ); }
+            Result.reserve( Params.size() );
+            for( auto Cursor = Text.data(); auto [Name, Value] : Params )
+                Cursor += Result.emplace_back( Cursor, Name.size() + 1 + Value.size() ).size();
             return Result;
         }
 
+        // requests of other slots completed on the way are handed to other workers
+        auto ReceiveStdin( char* Buffer, std::size_t N ) -> std::size_t
+        {
+            auto Completed = Connection::SlotList{};
+            auto Received = Connection_Ptr->ReceiveStdin( *Slot_Ptr, Buffer, N, Completed );
+            if( EventLoop_Ptr )
+            {
+                EventLoop_Ptr->Dispatch( Connection_Ptr, std::move( Completed ) );
+                if( ! Connection_Ptr->ExpectingStdin() ) EventLoop_Ptr->Store( Connection_Ptr );
+            }
+            return Received;
+        }
+
         auto Parse() -> int
         {
             // if not using nginx, disable persistent connection
-            if( GetParam( "SERVER_SOFTWARE" ).contains( "Apache" ) ) FCGX_Request_Ptr->keepConnection = false;
+            if( GetParam( "SERVER_SOFTWARE" ).contains( "Apache" ) ) Connection_Ptr->KeepConnection = false;
             using namespace ParseUtil;
-            Query.Json = {};  // .clear() cannot reset residual discarded state
+            Query.clear();
             Files.Storage.clear();
             Payload.clear();
 
-            Header.EnvPtr = FCGX_Request_Ptr->envp;
-            Cookie.EnvPtr = FCGX_Request_Ptr->envp;
+            Header.Index = &Slot_Ptr->Index;
+            Cookie.Reset( &Slot_Ptr->Index );
 
             Method = GetParam( "REQUEST_METHOD" );
             ContentType = GetParam( "CONTENT_TYPE" );
 
-            Payload.resize_and_overwrite( ( GetParam( "CONTENT_LENGTH" ) | ConvertTo<int> | FallBack( 0 ) ) + 1,  //
-                                          [Stream = FCGX_Request_Ptr->in]( char* Buffer, std::size_t N ) {        //
-                                              return FCGX_GetStr( Buffer, N, Stream );
-                                          } );
+            // form bodies are decoded inside Payload, only the query string needs DecodeBuffer
+            auto QueryString = GetParam( "QUERY_STRING" );
+            Query.Reserve( QueryString.size() );
 
-            auto QueryAppend = [&Result = Query.Json]( std::string_view Key, auto&& Value ) {
-                if( ! Key.empty() ) Result[Key].push_back( std::forward<decltype( Value )>( Value ) );
-            };
+            // duplicated keys are kept in order, see CountRepeated
+            for( auto Segment : QueryString | SplitBy( '&' ) )
+                for( auto [EncodedKey, EncodedValue] : Segment | SplitOnceBy( '=' ) | VIEW::pairwise )
+                    Query.AppendDecoded( EncodedKey, EncodedValue );
 
+            Progress = BodyProgress::Unread;
+            if( Config::LazyRequestBody )
             {
-                // read query string, then request body
-                // duplicated key-value will be overwritten
-                for( auto Segment : GetParam( "QUERY_STRING" ) | SplitBy( '&' ) )
-                    for( auto [EncodedKey, EncodedValue] : Segment | SplitOnceBy( '=' ) | VIEW::pairwise )
-                        QueryAppend( DecodeURLFragment( EncodedKey ), DecodeURLFragment( EncodedValue ) );
+                Bind();
+                return 0;
+            }
+            if( ReadBody() ) return 0;
+
+            // early response with error message
+            // caller does not see this iteration
+            Send(
+                "Status: 400\r\n"
+                "Content-Type: text/html; charset=UTF-8\r\n"
+                "\r\n"
+                "Invalid Json." );
+
+            std::println( "Responding 400 Bad Request to Request with invalid Json.\nReady to accept new request..." );
+
+            Finish();
+            return -1;
+        }
+
+        // Query / Files point back here while the body is unread
+        auto Bind() -> void
+        {
+            Query.Owner = Files.Owner = Progress == BodyProgress::Unread ? this : nullptr;
+            Query.Json.Owner = &Query;
+        }
+
+        // pulls the request body off the socket and parses it, once, immediately unless Config::LazyRequestBody
+        // false if a json body does not validate
+        auto ReadBody() -> bool
+        {
+            if( Progress != BodyProgress::Unread ) return true;
+            Progress = BodyProgress::Parsed;
+            Bind();  // upload routers may look at Query while the body is being parsed
+            using namespace ParseUtil;
 
+            // Query holds views into Payload, kept beyond small string capacity so they survive moving the request
+            // multipart bodies are consumed incrementally below, Payload only keeps what is not routed
+            Payload.reserve( 32 );
+            if( ContentType != HTTP::Content::MultiPart::FormData )
+                Payload.resize_and_overwrite( ( GetParam( "CONTENT_LENGTH" ) | ConvertTo<int> | FallBack( 0 ) ) + 1,  //
+                                              [this]( char* Buffer, std::size_t N ) {                                 //
+                                                  return ReceiveStdin( Buffer, N );
+                                              } );
+
+            {
                 switch( ContentType )
                 {
                     default : break;
                     case HTTP::Content::Application::FormURLEncoded :
                     {
+                        // decoded where it lies, Payload is ours and decoded text is never longer
+                        // Payload no longer holds the raw body afterwards
+                        auto DecodeInPlace = []( StrView Fragment ) {
+                            auto Start = const_cast<char*>( Fragment.data() );
+                            return StrView{ Start, DecodeURLInto( Fragment, Start ) };
+                        };
                         for( auto Segment : Payload | SplitBy( '&' ) )
                             for( auto [EncodedKey, EncodedValue] : Segment | SplitOnceBy( '=' ) | VIEW::pairwise )
-                                QueryAppend( DecodeURLFragment( EncodedKey ), DecodeURLFragment( EncodedValue ) );
+                                Query.Append( DecodeInPlace( EncodedKey ), DecodeInPlace( EncodedValue ) );
                         break;
                     }
                     case HTTP::Content::MultiPart::FormData :
                     {
                         auto _ = ScopedTimer( "MultipartParseTime" );
-                        auto BoundaryPattern = GetParam( "CONTENT_TYPE" ) | After( "boundary=" ) | TrimSpace;
-                        auto ExtendedBoundaryPattern = "\r\n--{}\r\nContent-Disposition: form-data; name="_FMT( BoundaryPattern );
-
-                        // remove trailing boundary to avoid empty ending after split
-                        auto PayloadView = Payload | TrimSpace | TrimTrailing( "--" ) | TrimTrailing( BoundaryPattern ) | TrimTrailing( "\r\n--" );
-                        if( PayloadView.empty() ) break;
-
-                        auto NameFieldPrefix = StrView{ "name=" };
-                        if( PayloadView.starts_with( ExtendedBoundaryPattern.substr( 2 ) ) )
-                        {  // enable ExtendedBoundaryPattern
-                            BoundaryPattern = ExtendedBoundaryPattern;
-                            NameFieldPrefix = NameFieldPrefix | CollapseToEnd;
-                        }
-                        else
-                        {  // fallback to standard
-                            BoundaryPattern = ExtendedBoundaryPattern | Before( "Content-Disposition" );
-                        }
+                        auto Boundary = GetParam( "CONTENT_TYPE" ) | After( "boundary=" ) | TrimSpace;
+                        if( Boundary.starts_with( '"' ) ) Boundary = Boundary | Between( '"' );
+                        if( Boundary.empty() ) break;
 
-                        PayloadView = PayloadView | TrimLeading( BoundaryPattern.substr( 2 ) );
-
-                        // at this point, PayloadView does not contain BoundaryPattern on both ends.
-
-                        for( auto&& Body : PayloadView | SplitBy( BoundaryPattern ) )
+                        // retained bytes are appended to Payload, located by offset until Payload stops growing
+                        struct Span
                         {
-                            auto [Header, Content] = Body | SplitOnceBy( "\r\n\r\n" );
-
-                            auto Name = Header | After( NameFieldPrefix ) | Between( '"' );
-                            if( Name.empty() ) break;  // should never happen?
+                            std::size_t Offset, Length;
+                        };
+                        struct Part
+                        {
+                            Span Name, FileName, ContentType, Content;
+                            std::shared_ptr<SpillFile> Spilled{};
+                        };
+                        auto Parts = std::pmr::vector<Part>{ Arena.Resource() };
+                        auto Retain = [this]( StrView Text ) {
+                            auto Offset = Payload.size();
+                            Payload.append( Text );
+                            return Span{ Offset, Text.size() };
+                        };
+                        auto Sink = UploadSink{};
+
+                        auto Parser = MultipartParser{ Boundary };
+                        auto OnPart = [&]( StrView Header ) {
+                            auto Name = Header | After( "name=" ) | Between( '"' );
                             auto FileName = Header | After( "filename=" ) | Between( '"' );
-                            auto ContentType = Header | After( "\r\n" ) | After( "Content-Type:" ) | TrimSpace;
+                            auto PartType = Header | After( "Content-Type:" );
+                            PartType = PartType.substr( 0, PartType.find( "\r\n" ) ) | TrimSpace;
+
+                            Sink = ! PartType.empty() && Config::UploadRouter ? Config::UploadRouter( *this, Name, FileName, PartType ) : UploadSink{};
+                            Parts.push_back( { Retain( Name ), Retain( FileName ), Retain( PartType ), Span{ Payload.size(), 0 } } );
+                        };
+                        auto OnContent = [&]( StrView Chunk ) {
+                            if( Sink ) return Sink( Chunk );
+                            auto& Current = Parts.back();
+                            if( ! Current.Spilled && Current.ContentType.Length > 0 && Current.Content.Length + Chunk.size() > Config::UploadSpillThreshold )
+                                if( ( Current.Spilled = SpillFile::Create() ) )
+                                {  // buffered head of the part moves along, it is the tail of Payload
+                                    Current.Spilled->Write( StrView{ Payload }.substr( Current.Content.Offset ) );
+                                    Payload.resize( Current.Content.Offset );
+                                    Current.Content.Length = 0;
+                                }
+                            if( Current.Spilled ) Current.Spilled->Write( Chunk );
+                            else Current.Content.Length += Retain( Chunk ).Length;
+                        };
+                        auto OnPartEnd = [&] {
+                            if( Sink ) std::exchange( Sink, {} )( {} );
+                        };
+
+                        // stdin is always read to the end, epilogue included, the connection may carry more requests
+                        auto Buffer = std::make_unique_for_overwrite<char[]>( Config::MultipartChunkSize );
+                        for( auto EndOfStdin = false; ! EndOfStdin; )
+                        {
+                            auto Received = ReceiveStdin( Buffer.get(), Config::MultipartChunkSize );
+                            EndOfStdin = Received < Config::MultipartChunkSize;
+                            if( ! Parser.Done() ) Parser.Feed( { Buffer.get(), Received }, OnPart, OnContent, OnPartEnd );
+                        }
+                        if( Sink ) Sink( {} );  // truncated upload, close the sink anyway
+
+                        auto View = [this]( Span Location ) { return StrView{ Payload }.substr( Location.Offset, Location.Length ); };
+                        for( auto&& [NameSpan, FileNameSpan, ContentTypeSpan, ContentSpan, Spilled] : Parts )
+                        {
+                            auto Name = View( NameSpan );
+                            if( Name.empty() ) continue;
+                            auto FileName = View( FileNameSpan );
+                            auto PartType = View( ContentTypeSpan );
+                            auto Content = View( ContentSpan );
 
-                            if( ContentType.empty() ) { QueryAppend( Name, Content ); }
+                            if( PartType.empty() ) { Query.Append( Name, Content ); }
                             else
                             {
-                                QueryAppend( Name, FileName );
-                                if( ! FileName.empty() || ! Content.empty() )  //
-                                    Files.Storage[Name].emplace_back( FileName, ContentType, Content );
+                                Query.Append( Name, FileName );
+                                if( ! FileName.empty() || ! Content.empty() || Spilled )  //
+                                    Files.Storage[Name].emplace_back( FileName, PartType, Content, std::move( Spilled ) );
                             }
                         }
                         break;
                     }
                     case HTTP::Content::Application::Json :
                     {
-                        Query.Json = Json::parse( Payload, nullptr, false );  // disable exception
-                        if( Query.Json.is_discarded() )
-                        {  // parse error
-                            // early response with error message
-                            // caller does not see this iteration
-                            // give caller the next request
-                            FCGX_PutS(
-                                "Status: 400\r\n"
-                                "Content-Type: text/html; charset=UTF-8\r\n"
-                                "\r\n"
-                                "Invalid Json.",
-                                FCGX_Request_Ptr->out );
-
-                            std::println( "Responding 400 Bad Request to Request with invalid Json.\nReady to accept new request..." );
-
-                            // re-using FCGX_Request struct, parse again
-                            if( FCGX_Accept_r( FCGX_Request_Ptr.get() ) == 0 ) return Parse();
-                            return -1;
-                        }
+                        // validated without building any tree, see Body<T>() and Query.Json
+                        if( glz::validate_json( Payload ) ) return false;
+                        Query.DeferJson( Payload );
                         break;
                     }
                 }
             }
-            return 0;
+            return true;
         }
 
-        Request() = default;
-        Request( const Request& ) = delete;
-        Request( Request&& Other ) = default;
-
-        Request( SocketFileDescriptor SocketFD, ConnectionFileDescriptor ConnectionFD, ReusableFD* ReusableFD_Ptr )  //
-            : FCGX_Request_Ptr{ std::make_unique_for_overwrite<FCGX_Request>().release() },
-              ReusableFD_Ptr{ ReusableFD_Ptr }
+        // chunked reads of a body left unread in lazy mode, Query / Files then only hold the query string
+        struct BodyStream
         {
-            auto Request_Ptr = FCGX_Request_Ptr.get();
-            (void)FCGX_InitRequest( Request_Ptr, SocketFD, FCGI_FAIL_ACCEPT_ON_INTR );
-            Request_Ptr->ipcFd = ConnectionFD;  // specify ipcFD, enable persistent connection
+            Request* Owner;
 
-            if( FCGX_Accept_r( Request_Ptr ) == 0 )
+            // fills the front of Buffer, empty at end of body
+            auto Read( std::span<char> Buffer ) const -> std::span<char>
             {
-                // FCGX_Request_Ptr ready, setup the rest of request object(parse request)
-                if( Parse() == 0 ) { return; }
+                if( Owner->Progress != BodyProgress::Streamed ) return {};
+                return Buffer.first( Owner->ReceiveStdin( Buffer.data(), Buffer.size() ) );
             }
+        };
+
+        auto Stream() -> BodyStream
+        {
+            if( Progress == BodyProgress::Unread ) Progress = BodyProgress::Streamed;
+            Bind();
+            return { this };
+        }
+
+        // a body left unread in lazy mode is given up, its remaining stdin records are dropped
+        // the connection is armed again, requests multiplexed on it and aborts keep being read while this one is served
+        // implied by BeginStream(), SSE_Start() and SSEHub::Subscribe()
+        auto AbandonBody() -> void
+        {
+            if( Progress != BodyProgress::Unread || Slot_Ptr == nullptr ) return;
+            Progress = BodyProgress::Abandoned;
+            Bind();
+            Slot_Ptr->StdinAbandoned = true;
+            if( EventLoop_Ptr && ! Connection_Ptr->ExpectingStdin() ) EventLoop_Ptr->Store( Connection_Ptr );
+        }
+
+        Request() = default;
+        Request( const Request& ) = delete;
+        Request( Request&& Other ) noexcept
+            : Arena{ Other.Arena },
+              Response{ std::move( Other.Response ) },
+              Files{ std::move( Other.Files ) },
+              Payload{ std::move( Other.Payload ) },
+              Query{ std::move( Other.Query ) },
+              Header{ Other.Header },
+              Cookie{ std::move( Other.Cookie ) },
+              Connection_Ptr{ std::move( Other.Connection_Ptr ) },
+              Slot_Ptr{ std::move( Other.Slot_Ptr ) },
+              Method{ Other.Method },
+              ContentType{ Other.ContentType },
+              EventLoop_Ptr{ Other.EventLoop_Ptr },
+              Progress{ Other.Progress }
+        {
+            Bind();
+        }
+
+        Request( std::shared_ptr<Connection> SourceConnection, std::shared_ptr<Connection::Slot> SourceSlot, EventLoop* EventLoop_Ptr )  //
+            : Arena{ RequestArena::Acquire() },
+              Response{ Arena.Resource() },
+              Files{ Arena.Resource() },
+              Query{ Arena.Resource() },
+              Cookie{ Arena.Resource() },
+              Connection_Ptr{ std::move( SourceConnection ) },
+              Slot_Ptr{ std::move( SourceSlot ) },
+              EventLoop_Ptr{ EventLoop_Ptr }
+        {
+            // Connection_Ptr ready, setup the rest of request object(parse request)
+            if( Connection_Ptr && Slot_Ptr && Parse() == 0 ) return;
 
-            // fail to obtain valid request, reset residual request data & allocation
-            // custom deleter of FCGX_Request_Ptr will do the cleanup
-            FCGX_InitRequest( Request_Ptr, {}, {} );
-            FCGX_Request_Ptr.reset();
+            // fail to obtain valid request, connection closed by upstream or already answered
+            Connection_Ptr.reset();
+            Slot_Ptr.reset();
 
-            if( TerminationToken.stop_requested() ) std::println( "Interrupted FCGX_Accept_r()." );
+            if( TerminationToken.stop_requested() ) std::println( "Interrupted while receiving request." );
         }
 
         static auto AcceptFrom( auto&&... args ) { return Request{ std::forward<decltype( args )>( args )... }; }
 
-        Request& operator=( Request&& Other ) = default;
+        // pmr members never take the allocator of their source on assignment, views would be left pointing into the
+        // source's arena, so the current request is finished and rebuilt in place, lease and allocators travel with the data
+        // well defined only because nothing derives from Request
+        Request& operator=( Request&& Other ) noexcept
+        {
+            if( this == &Other ) return *this;
+            std::destroy_at( this );
+            std::construct_at( this, std::move( Other ) );
+            return *this;
+        }
 
-        auto empty() const { return FCGX_Request_Ptr == nullptr; }
+        auto empty() const { return Slot_Ptr == nullptr; }
 
         auto operator[]( StrView Key, std::size_t Index = 0 ) const { return Query[Key, Index]; }
 
-        auto OutputIterator() const
+        // json body read straight into a reflected struct, empty on parse error
+        template<typename T>
+        auto Body() -> std::optional<T>
         {
-            struct OutIt
-            {
-                using difference_type = std::ptrdiff_t;
-                FCGX_Stream* Out;
-                auto operator*() const { return *this; }
-                auto& operator++() & { return *this; }
-                auto operator++( int ) const { return *this; }
-                auto operator=( char C ) const { return FCGX_PutChar( C, Out ); }
-            };
-            return OutIt{ FCGX_Request_Ptr->out };
+            ReadBody();
+            auto Result = std::optional<T>{ std::in_place };
+            if( glz::read_json( *Result, Payload ) ) return std::nullopt;
+            return Result;
+        }
+
+        auto OutputIterator() const { return std::back_inserter( Slot_Ptr->OutBuffer ); }
+
+        auto FlushIfFull() const
+        {
+            if( Slot_Ptr->OutBuffer.size() >= Config::OutputBufferSize ) Connection_Ptr->FlushOutput( *Slot_Ptr );
         }
 
-        auto Send( StrView Content ) const
+        auto Send( StrView Content ) const -> void
         {
-            if( Content.empty() || FCGX_Request_Ptr == nullptr ) return;
-            FCGX_PutStr( Content.data(), Content.length(), FCGX_Request_Ptr->out );
+            if( Content.empty() || Slot_Ptr == nullptr ) return;
+            Slot_Ptr->OutBuffer.append( Content );
+            FlushIfFull();
         }
 
         auto SendLine( StrView Content = {} ) const
@@ -1141,8 +3135,9 @@ namespace EasyFCGI
         requires( sizeof...( Args ) > 0 )                                          //
         auto Send( const std::format_string<Args...>& fmt, Args&&... args ) const  //
         {
-            if( FCGX_Request_Ptr == nullptr ) return;
+            if( Slot_Ptr == nullptr ) return;
             std::format_to( OutputIterator(), fmt, std::forward<Args>( args )... );
+            FlushIfFull();
         }
 
         template<typename... Args>
@@ -1161,27 +3156,146 @@ namespace EasyFCGI
                 case InternalUse_HeaderAlreadySent : return InternalUse_HeaderAlreadySent;
                 case HTTP::StatusCode::NoContent :   SendLine( "Status: 204" ); break;
                 default :
-                    SendLine( "Status: {}"_FMT( std::to_underlying( Response.StatusCode ) ) );
-                    SendLine( "Content-Type: {}; charset=UTF-8"_FMT( Response.ContentType.EnumLiteral() ) );
+                    if( auto Block = HTTP::PreRendered::Lookup( Response.StatusCode, Response.ContentType ); ! Block.empty() )
+                    {
+                        Send( Block );
+                        break;
+                    }
+                    if( auto Line = HTTP::PreRendered::StatusLine( Response.StatusCode ); ! Line.empty() ) Send( Line );
+                    else SendLine( "Status: {}", std::to_underlying( Response.StatusCode ) );
+                    if( Response.ContentType == HTTP::Content::MultiPart::ByteRanges )
+                        SendLine( "Content-Type: {}; boundary={}", Response.ContentType.EnumLiteral(), ByteRangeBoundary );
+                    else SendLine( "Content-Type: {}; charset=UTF-8", Response.ContentType.EnumLiteral() );
                     break;
             }
 
-            for( auto&& [K, V] : Response.Cookie ) SendLine( "Set-Cookie: {}={}"_FMT( K, V ) );
-            for( auto&& [K, V] : Response.Header ) SendLine( "{}: {}"_FMT( K, V ) );
+            // formatted straight into OutBuffer, no intermediate strings
+            // left there to go out in the same writev as the body, see FlushResponse / Finish
+            if( Response.Preset ) Send( Response.Preset->Block );
+            for( auto&& [K, V] : Response.Cookie ) SendLine( "Set-Cookie: {}={}", StrView{ K }, StrView{ V } );
+            for( auto&& [K, V] : Response.Header ) SendLine( "{}: {}", StrView{ K }, StrView{ V } );
             SendLine();
-            FCGX_FFlush( FCGX_Request_Ptr->out );
 
             return std::exchange( Response.StatusCode, InternalUse_HeaderAlreadySent );
         }
 
+        // pending header lines and the body, borrowed rather than copied into OutBuffer
         auto FlushResponse()
         {
-            Send( Response.Body );
+            auto Sent = Connection_Ptr->FlushOutput( *Slot_Ptr, Response.Body.Segments );
             Response.Body.clear();
-            return FCGX_FFlush( FCGX_Request_Ptr->out );
+            return Sent ? 0 : -1;
+        }
+
+        constexpr static auto ByteRangeBoundary = StrView{ "EasyFCGI-3f9c2a7e5b1d4608-ByteRange" };
+
+        // Response.File with Range of the request applied
+        // one range as 206, several as multipart/byteranges, none satisfiable as 416
+        auto FinishFile()
+        {
+            auto File = std::exchange( Response.File, {} );
+            auto FileType = Response.ContentType;
+            auto Ranges = std::vector<HTTP::ByteRange>{ { 0, File->Length } };
+            Response.SetHeader( "Accept-Ranges", StrView{ "bytes" } );
+            if( Response.StatusCode == HTTP::StatusCode::OK )
+                if( auto Requested = HTTP::ParseByteRanges( Header["Range"], File->Length ) ) Ranges = std::move( *Requested );
+
+            if( Ranges.empty() )
+            {
+                Response.Set( HTTP::StatusCode::RangeNotSatisfiable ).SetHeader( "Content-Range", "bytes */{}"_FMT( File->Length ) );
+                Response.Body.clear();
+                FlushHeader();
+                return Finish();
+            }
+            if( Ranges.size() == 1 )
+            {
+                auto [First, Length] = Ranges.front();
+                if( Length != File->Length )
+                    Response.Set( HTTP::StatusCode::PartialContent )
+                        .SetHeader( "Content-Range", "bytes {}-{}/{}"_FMT( First, First + Length - 1, File->Length ) );
+                Response.SetHeader( "Content-Length", std::to_string( Length ) );
+                FlushHeader();
+                if( Method != HTTP::Request::Method::HEAD ) Connection_Ptr->SendFile( *Slot_Ptr, File->FD, File->Offset + First, Length );
+                return Finish();
+            }
+
+            Response.Set( HTTP::StatusCode::PartialContent ).Set( HTTP::Content::MultiPart::ByteRanges );
+            FlushHeader();
+            if( Method == HTTP::Request::Method::HEAD ) return Finish();
+            for( auto [First, Length] : Ranges )
+            {
+                Send( "\r\n--{}\r\nContent-Type: {}\r\nContent-Range: bytes {}-{}/{}\r\n\r\n",  //
+                      ByteRangeBoundary, FileType.EnumLiteral(), First, First + Length - 1, File->Length );
+                if( ! Connection_Ptr->SendFile( *Slot_Ptr, File->FD, File->Offset + First, Length ) ) break;
+            }
+            auto Closing = "\r\n--{}--\r\n"_FMT( ByteRangeBoundary );
+            auto Tail = StrView{ Closing };
+            Finish( { &Tail, 1 } );
+        }
+
+        // end of request, connection goes back to EventLoop if upstream wants to keep it
+        // and no other request on it is still reading stdin, stdin left unread is dropped on arrival
+        // Tail goes out with the end of request records
+        auto Finish( std::span<const StrView> Tail = {} ) -> void
+        {
+            auto FinishedConnection = std::move( Connection_Ptr );
+            auto FinishedSlot = std::move( Slot_Ptr );
+            if( FinishedConnection->EndRequest( *FinishedSlot, Tail ) && EventLoop_Ptr && ! FinishedConnection->ExpectingStdin() )
+                EventLoop_Ptr->Store( std::move( FinishedConnection ) );
+        }
+
+        // finished by the temporary taking over, this object is left empty
+        auto EarlyFinish() { [[maybe_unused]] auto Finished = std::move( *this ); }
+
+        enum class StreamStatus : unsigned char { Written, WouldBlock, Closed };
+
+        // status, headers and Response.Body so far go out now
+        // content then follows through Write() as it is produced, instead of piling up in Response.Body
+        auto BeginStream() -> StreamStatus
+        {
+            if( Slot_Ptr == nullptr ) return StreamStatus::Closed;
+            AbandonBody();
+            FlushHeader();
+            return FlushResponse() == 0 ? StreamStatus::Written : StreamStatus::Closed;
+        }
+
+        // wrapped into STDOUT records and written straight away, nothing is buffered
+        // stream begins here if BeginStream was not called, status and headers go out first
+        // blocks while the socket send buffer is full, unless Wait is false:
+        // WouldBlock and nothing taken while another request is writing or an earlier tail is still unsent,
+        // otherwise Data is taken whole, what the socket does not accept now is queued and goes out first later
+        auto Write( std::span<const char> Data, bool Wait = true ) -> StreamStatus
+        {
+            if( Slot_Ptr == nullptr || ! Connection_Ptr->Alive() ) return StreamStatus::Closed;
+            auto Segment = StrView{ Data.data(), Data.size() };
+            auto Streaming = Response.StatusCode == HTTP::StatusCode::InternalUse_HeaderAlreadySent;
+            if( Wait )
+            {
+                if( ! Streaming )
+                    if( auto Status = BeginStream(); Status != StreamStatus::Written ) return Status;
+                return Connection_Ptr->FlushOutput( *Slot_Ptr, { &Segment, 1 } ) ? StreamStatus::Written : StreamStatus::Closed;
+            }
+
+            auto Hold = Connection_Ptr->TryHoldWriter();
+            if( ! Hold ) return Connection_Ptr->Alive() ? StreamStatus::WouldBlock : StreamStatus::Closed;
+            auto Sent = false;
+            if( Streaming ) Sent = Connection_Ptr->FlushOutputNow( *Slot_Ptr, { &Segment, 1 } );
+            else
+            {
+                AbandonBody();
+                FlushHeader();
+                Response.Body.Borrow( Segment );
+                Sent = Connection_Ptr->FlushOutputNow( *Slot_Ptr, Response.Body.Segments );
+                Response.Body.clear();
+            }
+            return Sent ? StreamStatus::Written : StreamStatus::Closed;
         }
 
-        auto EarlyFinish() { std::exchange( *this, {} ); }
+        // anything left in Response.Body goes out with the end of request
+        auto EndStream()
+        {
+            if( Slot_Ptr ) Finish( Response.Body.Segments );
+        }
 
         auto SSE_Start()
         {
@@ -1194,6 +3308,7 @@ namespace EasyFCGI
                 .Set( HTTP::StatusCode::OK )  //
                 .Set( HTTP::Content::Text::EventStream )
                 .SetHeader( "Cache-Control", "no-cache" );
+            AbandonBody();
             FlushHeader();
             FlushResponse();
         }
@@ -1203,18 +3318,185 @@ namespace EasyFCGI
             ( Send( Content ), ... );
             SendLine();
             SendLine();
-            return FCGX_FFlush( FCGX_Request_Ptr->out );
+            return Connection_Ptr->FlushOutput( *Slot_Ptr ) ? 0 : -1;
+        };
+
+        auto SSE_Error() const -> int { return Connection_Ptr->LastError.load( std::memory_order_relaxed ); }
+
+        ~Request()
+        {
+            if( ! Slot_Ptr ) return;
+            if( Response.File && Response.StatusCode != HTTP::StatusCode::InternalUse_HeaderAlreadySent )
+            {
+                FinishFile();
+                return;
+            }
+            // status, headers, body and end of request in a single writev
+            if( FlushHeader() == HTTP::StatusCode::NoContent ) Response.Body.clear();
+            Finish( Response.Body.Segments );
+        }
+    };
+
+    // server-sent events fanned out to many clients by one background writer
+    // a handler hands its request over with Subscribe() and returns, no worker stays pinned to the client
+    // each event is formatted once, subscribers only differ in their 8 byte record headers
+    // writes never block, WriteLock is held for one frame at a time
+    // a frame cut short is left in the connection's Backlog, the subscriber then waits for room in the socket
+    struct SSEHub
+    {
+        struct Frame
+        {
+            std::string Content;
+        };
+
+        struct Subscriber
+        {
+            std::shared_ptr<Connection> Conn;
+            std::shared_ptr<Connection::Slot> Slot;
+            EventLoop* Loop;
+            std::deque<std::shared_ptr<const Frame>> Queue;
+            bool Listed{ false };  // in Pending, until the queue and the connection's Backlog are both out
+
+            auto Gone() const { return Slot->Aborted || ! Conn->Alive(); }
         };
+        using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+        std::mutex InboxLock;
+        std::vector<std::pair<std::string, std::shared_ptr<Subscriber>>> NewSubscribers;
+        std::vector<std::pair<std::string, std::shared_ptr<const Frame>>> NewFrames;
+        int WakeUpFD{ ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) };
+
+        // touched by the writer only
+        std::map<std::string, SubscriberList, std::less<>> Topics;
+        SubscriberList Pending;
+
+        std::jthread Writer{ [this]( std::stop_token Token ) { Run( Token ); } };
+
+        SSEHub() = default;
+        SSEHub( const SSEHub& ) = delete;
+        ~SSEHub()
+        {
+            Writer.request_stop();
+            WakeUp();
+            Writer.join();
+            ::close( WakeUpFD );
+        }
+
+        auto WakeUp() const -> void { (void)::eventfd_write( WakeUpFD, 1 ); }
+
+        // sends the event stream header, then takes the request over, Source is left empty
+        auto Subscribe( Request& Source, StrView Topic ) -> bool
+        {
+            if( Source.empty() ) return false;
+            Source.SSE_Start();
+            if( Source.SSE_Error() ) return false;
+            auto Target = std::make_shared<Subscriber>( std::move( Source.Connection_Ptr ), std::move( Source.Slot_Ptr ), Source.EventLoop_Ptr );
+            // armed again, aborts and requests multiplexed on the same connection keep being read
+            if( Target->Loop && ! Target->Conn->ExpectingStdin() ) Target->Loop->Store( Target->Conn );
+            {
+                auto _ = std::lock_guard{ InboxLock };
+                NewSubscribers.emplace_back( Topic, std::move( Target ) );
+            }
+            WakeUp();
+            return true;
+        }
+
+        // multi-line Data becomes one data field per line
+        auto Publish( StrView Topic, StrView Data, StrView EventName = {} )
+        {
+            if( Data.ends_with( '\n' ) ) Data.remove_suffix( 1 );
+            auto Encoded = std::make_shared<Frame>();
+            if( ! EventName.empty() ) Encoded->Content.append( "event: " ).append( EventName ).append( "\n" );
+            for( auto Line : Data | ParseUtil::SplitBy( '\n' ) ) Encoded->Content.append( "data: " ).append( Line ).append( "\n" );
+            Encoded->Content.append( "\n" );
+            {
+                auto _ = std::lock_guard{ InboxLock };
+                NewFrames.emplace_back( Topic, std::move( Encoded ) );
+            }
+            WakeUp();
+        }
+
+        enum class Progress : unsigned char { Drained, Waiting, Dropped };
+
+        // records encoded on the stack by FlushOutputNow, WriteLock released between frames
+        // Waiting while another request is writing or the socket is full
+        static auto Drain( Subscriber& Target ) -> Progress
+        {
+            while( ! Target.Gone() )
+            {
+                auto Hold = Target.Conn->TryHoldWriter();
+                if( ! Hold ) return Target.Conn->Alive() ? Progress::Waiting : Progress::Dropped;
+                if( Target.Queue.empty() ) return Progress::Drained;
+                auto Content = StrView{ Target.Queue.front()->Content };
+                if( ! Target.Conn->FlushOutputNow( *Target.Slot, { &Content, 1 } ) ) return Progress::Dropped;
+                Target.Queue.pop_front();
+            }
+            return Progress::Dropped;
+        }
 
-        auto SSE_Error() const { return FCGX_GetError( FCGX_Request_Ptr->out ); }
+        // end of request sent as for any finished request, connection handed back to its EventLoop
+        static auto Close( Subscriber& Target )
+        {
+            if( Target.Conn->EndRequest( *Target.Slot ) && Target.Loop && ! Target.Conn->ExpectingStdin() ) Target.Loop->Store( Target.Conn );
+        }
 
-        virtual ~Request()
+        auto Run( std::stop_token Token ) -> void
         {
-            if( ! FCGX_Request_Ptr ) return;
-            // std::println( "ID: [ {:2},{:2} ] Request Complete...", FCGX_Request_Ptr->ipcFd, FCGX_Request_Ptr->requestId );
-            if( FlushHeader() != HTTP::StatusCode::NoContent ) FlushResponse();
-            FCGX_Finish_r( FCGX_Request_Ptr.get() );
-            if( ReusableFD_Ptr && FCGX_Request_Ptr->ipcFd != -1 ) ReusableFD_Ptr->Store( FCGX_Request_Ptr->ipcFd );
+            auto PollFDs = std::vector<pollfd>{};
+            auto NextSweep = std::chrono::steady_clock::now();
+            while( ! Token.stop_requested() )
+            {
+                // waiting subscribers sleep until their socket has room
+                // a busy WriteLock belongs to a writer pushing bytes or waiting for that same room
+                PollFDs.assign( 1, { .fd = WakeUpFD, .events = POLLIN, .revents = 0 } );
+                for( auto& Target : Pending ) PollFDs.push_back( { .fd = Target->Conn->FD, .events = POLLOUT, .revents = 0 } );
+                (void)::poll( PollFDs.data(), PollFDs.size(), Config::SSESweepMilliseconds );
+                if( auto Now = std::chrono::steady_clock::now(); Now >= NextSweep )
+                    for( NextSweep = Now + std::chrono::milliseconds( Config::SSESweepMilliseconds ); auto& [Topic, Subscribers] : Topics )
+                        std::erase_if( Subscribers, [this]( auto& Target ) {
+                            if( ! Target->Gone() || Target->Listed ) return false;
+                            Close( *Target );
+                            return true;
+                        } );
+
+                auto Arrived = decltype( NewSubscribers ){};
+                auto Published = decltype( NewFrames ){};
+                {
+                    auto _ = std::lock_guard{ InboxLock };
+                    Arrived.swap( NewSubscribers );
+                    Published.swap( NewFrames );
+                }
+                eventfd_t Discard;
+                (void)::eventfd_read( WakeUpFD, &Discard );
+                for( auto& [Topic, Target] : Arrived ) Topics[Topic].push_back( std::move( Target ) );
+                for( auto& [Topic, Encoded] : Published )
+                {
+                    auto Found = Topics.find( Topic );
+                    if( Found == Topics.end() ) continue;
+                    for( auto& Target : Found->second )
+                    {
+                        if( ! std::exchange( Target->Listed, true ) ) Pending.push_back( Target );
+                        Target->Queue.push_back( Encoded );
+                    }
+                }
+
+                // drained subscribers leave Pending, dropped ones leave their topic too
+                std::erase_if( Pending, [this]( auto& Target ) {
+                    auto Status = Target->Queue.size() <= Config::SSEQueueLimit ? Drain( *Target ) : Progress::Dropped;
+                    if( Status == Progress::Waiting ) return false;
+                    Target->Listed = false;
+                    if( Status == Progress::Drained ) return true;
+                    Target->Queue.clear();
+                    Close( *Target );
+                    for( auto& [Topic, Subscribers] : Topics ) std::erase( Subscribers, Target );
+                    return true;
+                } );
+            }
+
+            for( auto& [Topic, Subscribers] : Topics )
+                for( auto& Target : Subscribers ) Close( *Target );
+            Topics.clear();
+            Pending.clear();
         }
     };
 
@@ -1243,32 +3525,77 @@ namespace EasyFCGI
         {
             RequestQueue() = delete;
             RequestQueue( const RequestQueue& ) = delete;
-            RequestQueue( SocketFileDescriptor SourceSocketFD ) : ListenSocket{ SourceSocketFD } {};
+            // several workers may be woken up by the same connection,
+            // losers of accept() should return immediately instead of blocking
+            RequestQueue( SocketFileDescriptor SourceSocketFD ) : ListenSocket{ SourceSocketFD }
+            {
+                ::fcntl( ListenSocket, F_SETFL, ::fcntl( ListenSocket, F_GETFL ) | O_NONBLOCK );
+            };
 
             SocketFileDescriptor ListenSocket;
 
-            struct ReusableFD ReusableFD{};
+            struct EventLoop EventLoop{ ListenSocket };
 
-            auto WaitForListenSocket( int Timeout = -1 ) const { return PollFor( ListenSocket, POLLIN, Timeout ); }
-            auto ListenSocketActivated() const { return WaitForListenSocket( 0 ); }
-
-            auto NextRequest() { return Request::AcceptFrom( ListenSocket, ReusableFD.Load().value_or( -1 ), &ReusableFD ); }
+            // a readable connection may complete several multiplexed requests at once,
+            // the first is served here, the rest are dispatched to other workers
+            auto NextRequest( EventLoop::Event Ready )
+            {
+                auto [Source, Conn, Slot] = std::move( Ready );
+                if( Source == EventLoop::EventSource::NewConnection )
+                {
+                    if( ! EventLoop.Limit.TryAcquireConnection() )
+                    {
+                        EventLoop.UpdateAccept();
+                        return Request{};
+                    }
+                    auto ConnectionFD = ::accept4( ListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+                    if( ConnectionFD == -1 )
+                    {
+                        EventLoop.Limit.ReleaseConnection();
+                        return Request{};
+                    }
+                    Conn = std::make_shared<Connection>( ConnectionFD, &EventLoop.Limit );
+                }
+                if( ! Slot )
+                {
+                    auto Completed = Conn->Pump();
+                    if( ! Conn->ExpectingStdin() ) EventLoop.Store( Conn );
+                    if( Completed.empty() ) return Request{};
+                    Slot = std::move( Completed.front() );
+                    Completed.erase( Completed.begin() );
+                    EventLoop.Dispatch( Conn, std::move( Completed ) );
+                }
+                return Request::AcceptFrom( std::move( Conn ), std::move( Slot ), &EventLoop );
+            }
 
             struct Sentinel
             {};
             struct Iterator
             {
                 RequestQueue& AttachedQueue;
+                EventLoop::Event ReadyEvent{};
                 auto& operator++() &
                 {
                     //no-op
                     return *this;
                 }
-                auto operator*() const { return AttachedQueue.ListenSocketActivated() ? AttachedQueue.NextRequest() : Request{}; }
-                bool operator==( Sentinel ) const
+                auto operator*() const
+                {
+                    switch( ReadyEvent.Source )
+                    {
+                        using enum EventLoop::EventSource;
+                        case NewConnection :
+                        case KeptAliveConnection :
+                        case PendingRequest :      return AttachedQueue.NextRequest( ReadyEvent );
+                        default :                  return Request{};
+                    }
+                }
+                bool operator==( Sentinel )
                 {
-                    auto _ = ScopedTimer( "WaitForListenSocket" );
-                    return ! AttachedQueue.WaitForListenSocket();
+                    auto _ = ScopedTimer( "WaitForEvent" );
+                    ReadyEvent = AttachedQueue.EventLoop.Wait();
+                    using enum EventLoop::EventSource;
+                    return ReadyEvent.Source == Interrupted || ReadyEvent.Source == Termination;
                 }
             };
 
@@ -1288,7 +3615,7 @@ namespace EasyFCGI
         Server( const FS::path& SocketPath )
             : Server( SocketPath.empty()  //
                           ? SocketFileDescriptor{}
-                          : FCGX_OpenSocket( SocketPath.c_str(), Config::DefaultBackLogNumber ) )
+                          : OpenListenSocket( SocketPath, Config::DefaultBackLogNumber ) )
         {
             auto FD = RequestQueue.ListenSocket;
             if( FD == -1 )
@@ -1296,28 +3623,129 @@ namespace EasyFCGI
                 std::println( "Failed to open socket." );
                 std::exit( -1 );
             }
-            if( FD > 0 ) { FS::permissions( SocketPath, FS::perms::all ); }
+            if( FD > 0 && FS::exists( SocketPath ) ) { FS::permissions( SocketPath, FS::perms::all ); }
         }
-    };
 
-    namespace DebugInfo
-    {
-        typedef struct FCGX_Stream_Data
-        {
-            unsigned char* buff;
-            int bufflen;
-            unsigned char* mBuff;
-            unsigned char* buffStop;
-            int type;
-            int eorStop;
-            int skip;
-            int contentLen;
-            int paddingLen;
-            int isAnythingWritten;
-            int rawWrite;
-            FCGX_Request* reqDataPtr;
-        } FCGX_Stream_Data;
-    }  // namespace DebugInfo
+        // each worker accepts from the shared ListenSocket and serves one request at a time
+        // returns after termination signal, when all workers are joined
+        template<std::invocable<Request&> Handler>
+        auto Run( Handler&& HandleRequest, std::size_t WorkerCount = Config::DefaultWorkerCount )
+        {
+            RequestQueue.EventLoop.Limit.Configure( WorkerCount );
+            auto Workers = std::vector<std::jthread>{};
+            Workers.reserve( WorkerCount );
+            while( Workers.size() < std::max( WorkerCount, 1uz ) )
+                Workers.emplace_back( [this, &HandleRequest] {
+                    while( ! TerminationToken.stop_requested() )
+                        for( auto&& Request : RequestQueue )
+                        {
+                            if( Request.empty() ) continue;
+                            try
+                            {
+                                HandleRequest( Request );
+                            }
+                            catch( const std::exception& e )
+                            {
+                                std::println( "[ Error ] Uncaught exception from request handler : {}", e.what() );
+                                if( Request.Response.StatusCode != HTTP::StatusCode::InternalUse_HeaderAlreadySent )
+                                    Request.Response.Reset().Set( HTTP::StatusCode::InternalServerError );
+                            }
+                        }
+                } );
+            std::println( "Running with {} worker threads...", Workers.size() );
+        }
+
+        // supervisor forks ProcessCount children sharing ListenSocket, each serving with Run()
+        // crashed children are replaced, children crashing on startup and failed forks are retried with backoff
+        // termination signal is forwarded to every child
+        // a crashing or non thread-safe handler only affects its own process
+        // returns in the supervisor after all children exited
+        template<std::invocable<Request&> Handler>
+        auto RunPreFork( Handler&& HandleRequest, std::size_t ProcessCount = Config::DefaultWorkerCount, std::size_t WorkerCount = 1 )
+        {
+            using Clock = std::chrono::steady_clock;
+            using Milliseconds = std::chrono::milliseconds;
+
+            // fixed size, also read from the signal handler
+            // 0 for a child not running, respawned at RestartAt unless terminating
+            auto Children = std::vector<pid_t>( std::max( ProcessCount, 1uz ), 0 );
+            auto StartedAt = std::vector<Clock::time_point>( Children.size() );
+            auto RestartAt = std::vector<Clock::time_point>( Children.size() );
+            auto Backoff = std::vector<Milliseconds>( Children.size(), Milliseconds{ 0 } );
+            auto ForwardTermination = std::stop_callback( TerminationToken, [&Children, Supervisor = ::getpid()] {
+                if( ::getpid() != Supervisor ) return;
+                for( auto PID : Children )
+                    if( PID > 0 ) ::kill( PID, SIGTERM );
+            } );
+
+            auto ScheduleRestart = [&]( std::size_t Index, bool Failed ) {
+                Backoff[Index] = Failed ? std::clamp( Backoff[Index] * 2, Milliseconds{ Config::ProcessRestartMinMilliseconds },
+                                                      Milliseconds{ Config::ProcessRestartMaxMilliseconds } )
+                                        : Milliseconds{ 0 };
+                RestartAt[Index] = Clock::now() + Backoff[Index];
+            };
+
+            auto Spawn = [&]( std::size_t Index ) {
+                std::fflush( stdout );  // buffered logs would be printed again by the child
+                auto PID = ::fork();
+                if( PID == -1 )
+                {
+                    ScheduleRestart( Index, true );
+                    std::println( "[ Error ] Fail to fork worker process : {}, retrying in {}ms", std::strerror( errno ), Backoff[Index].count() );
+                    return;
+                }
+                if( PID > 0 )
+                {
+                    Children[Index] = PID;
+                    StartedAt[Index] = Clock::now();
+                    return;
+                }
+
+                // child process
+                ::close( TerminationFD );
+                TerminationFD = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+                RequestQueue.EventLoop.Reopen();
+                RequestQueue.EventLoop.Limit.ProcessCount = Children.size();
+                Run( HandleRequest, WorkerCount );
+                std::exit( 0 );
+            };
+
+            for( auto Index : VIEW::iota( 0uz, Children.size() ) ) Spawn( Index );
+            std::println( "Supervising {} worker processes...", Children.size() );
+
+            while( true )
+            {
+                // respawn children whose restart is due, remember the earliest one still waiting
+                auto NextRestart = std::optional<Clock::time_point>{};
+                if( ! TerminationToken.stop_requested() )
+                    for( auto Index : VIEW::iota( 0uz, Children.size() ) )
+                    {
+                        if( Children[Index] == 0 && RestartAt[Index] <= Clock::now() ) Spawn( Index );
+                        if( Children[Index] == 0 ) NextRestart = std::min( NextRestart.value_or( RestartAt[Index] ), RestartAt[Index] );
+                    }
+                auto Running = RNG::any_of( Children, []( pid_t PID ) { return PID > 0; } );
+                if( ! Running && ! NextRestart ) break;
+
+                auto Status = 0;
+                auto Exited = ::waitpid( -1, &Status, NextRestart ? WNOHANG : 0 );
+                if( Exited == 0 || ( Exited == -1 && errno == ECHILD ) )
+                {
+                    if( ! NextRestart ) break;
+                    // sleep until the next restart is due, still reaping crashed children at the min restart delay
+                    auto Remain = std::chrono::duration_cast<Milliseconds>( *NextRestart - Clock::now() ).count();
+                    PollFor( TerminationFD, POLLIN, static_cast<int>( std::clamp<decltype( Remain )>( Remain, 1, Config::ProcessRestartMinMilliseconds ) ) );
+                    continue;
+                }
+                auto Child = RNG::find( Children, Exited );
+                if( Exited == -1 || Child == Children.end() ) continue;
+                auto Index = static_cast<std::size_t>( Child - Children.begin() );
+                *Child = 0;
+                if( TerminationToken.stop_requested() ) continue;
+                ScheduleRestart( Index, Clock::now() - StartedAt[Index] < Milliseconds{ Config::ProcessStableMilliseconds } );
+                std::println( "[ Warn ] Worker process {} exited with status {}, restarting in {}ms...", Exited, Status, Backoff[Index].count() );
+            }
+        }
+    };
 
 }  // namespace EasyFCGI
 
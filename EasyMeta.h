@@ -3,7 +3,10 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstdint>
 #include <limits>
+#include <utility>
 #include <string_view>
 #include <type_traits>
 #include <concepts>
@@ -142,5 +145,89 @@ namespace EasyMeta
         return FixedString{ data };
     }
 
+    // lookup table over a fixed set of keys, every key owning its own slot
+    // the hash seed is searched at compile time, a lookup is one hash, one index and a single compare
+    // keys are strings or integral / enum values, build it into a constexpr variable so the search never runs at runtime
+    template<typename KeyType, typename ValueType, std::size_t N>
+    struct PerfectHash
+    {
+        using Entry = std::pair<KeyType, ValueType>;
+        constexpr static auto TableSize = std::bit_ceil( N * 2 );
+        constexpr static auto MaxSeed = 1uz << 20;
+        static_assert( N > 0 && N < MaxOf<std::uint16_t> );
+
+        std::array<Entry, N> Entries{};
+        std::array<std::uint16_t, TableSize> Slots{};  // position in Entries + 1, 0 for empty
+        std::size_t Seed{ 0 };
+
+        static constexpr auto Hash( const KeyType& Key, std::size_t Seed ) noexcept -> std::size_t
+        {
+            if constexpr( std::integral<KeyType> || std::is_enum_v<KeyType> )
+            {
+                auto X = ( static_cast<std::uint64_t>( Key ) ^ Seed ) * 0x9E3779B97F4A7C15u;
+                return static_cast<std::size_t>( X ^ ( X >> 32 ) );
+            }
+            else
+            {  // FNV-1a
+                auto X = 0xCBF29CE484222325u ^ Seed;
+                for( auto C : std::string_view{ Key } ) X = ( X ^ static_cast<unsigned char>( C ) ) * 0x100000001B3u;
+                return static_cast<std::size_t>( X ^ ( X >> 32 ) );
+            }
+        }
+
+        constexpr PerfectHash( const Entry ( &Table )[N] ) : PerfectHash( std::to_array( Table ) ) {}
+        constexpr PerfectHash( const std::array<Entry, N>& Table ) : Entries{ Table }
+        {
+            // no seed separates equal keys, fail before searching them all
+            for( auto First = 0uz; First < N; ++First )
+                for( auto Second = First + 1; Second < N; ++Second )
+                    if( Entries[First].first == Entries[Second].first ) throw "duplicated key in perfect hash table";
+            for( ; Seed < MaxSeed; ++Seed )
+            {
+                Slots.fill( 0 );
+                auto Collided = false;
+                for( auto Position = 0uz; Position < N && ! Collided; ++Position )
+                {
+                    auto& Slot = Slots[Hash( Entries[Position].first, Seed ) & ( TableSize - 1 )];
+                    Collided = Slot != 0;
+                    Slot = static_cast<std::uint16_t>( Position + 1 );
+                }
+                if( ! Collided ) return;
+            }
+            throw "no perfect hash seed found";
+        }
+
+        // position in Entries + 1, 0 if not found
+        constexpr auto PositionOf( const KeyType& Key ) const noexcept -> std::size_t
+        {
+            auto Position = Slots[Hash( Key, Seed ) & ( TableSize - 1 )];
+            return Position != 0 && Entries[Position - 1].first == Key ? Position : 0;
+        }
+
+        constexpr auto Find( const KeyType& Key ) const noexcept -> const ValueType*
+        {
+            auto Position = PositionOf( Key );
+            return Position ? &Entries[Position - 1].second : nullptr;
+        }
+
+        constexpr auto FindOr( const KeyType& Key, ValueType Default ) const noexcept -> ValueType
+        {
+            auto Position = PositionOf( Key );
+            return Position ? Entries[Position - 1].second : Default;
+        }
+    };
+
+    template<typename KeyType, typename ValueType, std::size_t N>
+    constexpr auto MakePerfectHash( const std::pair<KeyType, ValueType> ( &Table )[N] )
+    {
+        return PerfectHash<KeyType, ValueType, N>{ Table };
+    }
+
+    template<typename KeyType, typename ValueType, std::size_t N>
+    constexpr auto MakePerfectHash( const std::array<std::pair<KeyType, ValueType>, N>& Table )
+    {
+        return PerfectHash<KeyType, ValueType, N>{ Table };
+    }
+
 }  // namespace EasyMeta
 #endif
@@ -0,0 +1,110 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyBenchmark.h"
+#include <mutex>
+#include <barrier>
+#include <unistd.h>
+
+// connection recycling as done before EventLoop::ReadyConnections:
+// pipe write / poll / read under one mutex, per request
+struct PipeRecycler
+{
+    int PipeFD[2];
+    std::mutex PipeLock;
+    PipeRecycler() { (void)::pipe( PipeFD ); }
+    ~PipeRecycler()
+    {
+        ::close( PipeFD[0] );
+        ::close( PipeFD[1] );
+    }
+    auto Store( int FD )
+    {
+        auto _ = std::lock_guard{ PipeLock };
+        return ::write( PipeFD[1], &FD, sizeof( FD ) ) >= 0;
+    }
+    auto Load() -> std::optional<int>
+    {
+        auto _ = std::lock_guard{ PipeLock };
+        if( EasyFCGI::PollFor( PipeFD[0], POLLIN, 0 ) )
+        {
+            auto FD = int{};
+            if( ::read( PipeFD[0], &FD, sizeof( FD ) ) >= 0 ) return FD;
+        }
+        return std::nullopt;
+    }
+};
+
+struct RingRecycler
+{
+    EasyFCGI::MPMCRing<int, EasyFCGI::Config::ReadyConnectionCapacity> Ring;
+    auto Store( int FD ) { return Ring.TryPush( FD ); }
+    auto Load() { return Ring.TryPop(); }
+};
+
+// one iteration recycles RequestsPerIteration connections on every worker
+constexpr auto RequestsPerIteration = 1000;
+
+// workers are started once per benchmark and wait on a barrier between rounds,
+// so thread creation does not end up in the measurement
+template<typename Recycler>
+struct RecycleWorkers
+{
+    Recycler& Target;
+    std::barrier<> RoundStart, RoundEnd;
+    std::atomic<bool> Stopping{ false };
+    std::vector<std::jthread> Workers;
+
+    RecycleWorkers( Recycler& Target, int WorkerCount ) : Target{ Target }, RoundStart{ WorkerCount + 1 }, RoundEnd{ WorkerCount + 1 }
+    {
+        for( auto _ : std::views::iota( 0, WorkerCount ) )
+            Workers.emplace_back( [this] {
+                while( true )
+                {
+                    RoundStart.arrive_and_wait();
+                    if( Stopping ) return;
+                    for( auto FD : std::views::iota( 0, RequestsPerIteration ) )
+                    {
+                        this->Target.Store( FD );
+                        (void)this->Target.Load();
+                    }
+                    RoundEnd.arrive_and_wait();
+                }
+            } );
+    }
+
+    ~RecycleWorkers()
+    {
+        Stopping = true;
+        RoundStart.arrive_and_wait();
+    }
+
+    auto Round()
+    {
+        RoundStart.arrive_and_wait();
+        RoundEnd.arrive_and_wait();
+    }
+};
+
+int main()
+{
+    auto Pipe = PipeRecycler{};
+    auto Ring = std::make_unique<RingRecycler>();
+
+    {
+        auto Workers = RecycleWorkers{ Pipe, 1 };
+        for( auto _ : Benchmark( "pipe + mutex, 1 worker   (x1000 req)" ).AsBaseLine() ) Workers.Round();
+    }
+    {
+        auto Workers = RecycleWorkers{ *Ring, 1 };
+        for( auto _ : Benchmark( "MPMCRing, 1 worker       (x1000 req)" ) ) Workers.Round();
+    }
+    {
+        auto Workers = RecycleWorkers{ Pipe, 8 };
+        for( auto _ : Benchmark( "pipe + mutex, 8 workers  (x1000 req)" ) ) Workers.Round();
+    }
+    {
+        auto Workers = RecycleWorkers{ *Ring, 8 };
+        for( auto _ : Benchmark( "MPMCRing, 8 workers      (x1000 req)" ) ) Workers.Round();
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyBenchmark.h"
+
+using EasyFCGI::StrView;
+using ParseUtil::operator""_FMT;
+
+// split based decoder ParseUtil::DecodeURLInto replaced, the baseline here
+auto DecodeURLFragment_OLD( StrView Fragment, std::string Result = {} ) -> std::string
+{
+    using namespace ParseUtil;
+    constexpr auto EncodeDigitWidth = 2;
+    auto [FirstPart, OtherParts] = Fragment | SplitBy( '%' ) | SplitAt( 1 );
+    for( auto LeadingText : FirstPart ) Result += LeadingText | RestoreSpaceChar;
+    for( auto Segment : OtherParts )
+    {
+        auto [Encoded, Unencoded] = Segment | SplitAt( EncodeDigitWidth );
+        Result += Encoded.length() >= EncodeDigitWidth ? HexToChar( Encoded ) : '?';
+        Result += Unencoded | RestoreSpaceChar;
+    }
+    return Result;
+}
+
+// form body of a typical search / filter page, mostly clean text with scattered escapes
+auto MakeFormBody( std::size_t FieldCount )
+{
+    auto Body = std::string{};
+    for( auto Index : std::views::iota( 0uz, FieldCount ) )
+        Body += "{}field_{}=Some+text+with+a%20few%2Fescapes%3A+and%2C+some+longer+plain+runs+in+between{}"_FMT(  //
+            Index == 0 ? "" : "&", Index, Index );
+    return Body;
+}
+
+// one iteration decodes every key and value of the body RepeatsPerIteration times
+constexpr auto RepeatsPerIteration = 100;
+
+auto DecodeFields( StrView Body, auto Decode )
+{
+    auto Total = 0uz;
+    for( auto _ : std::views::iota( 0, RepeatsPerIteration ) )
+        for( auto Segment : Body | ParseUtil::SplitBy( '&' ) )
+            for( auto Fragment : Segment | ParseUtil::SplitOnceBy( '=' ) ) Total += Decode( Fragment ).size();
+    return Total;
+}
+
+int main()
+{
+    auto Body = MakeFormBody( 64 );
+
+    auto SplitBased = []( StrView Fragment ) { return DecodeURLFragment_OLD( Fragment ); };
+    auto Vectorized = []( StrView Fragment ) { return ParseUtil::DecodeURLFragment( Fragment, std::string{} ); };
+    auto Buffer = std::string( Body.size(), '\0' );
+    auto IntoBuffer = [&]( StrView Fragment ) { return StrView{ Buffer.data(), ParseUtil::DecodeURLInto( Fragment, Buffer.data() ) }; };
+
+    for( auto _ : Benchmark( "SplitBy + RestoreSpaceChar  (x100 body)" ).AsBaseLine() ) DecodeFields( Body, SplitBased );
+    for( auto _ : Benchmark( "DecodeURLFragment           (x100 body)" ) ) DecodeFields( Body, Vectorized );
+    for( auto _ : Benchmark( "DecodeURLInto, one buffer   (x100 body)" ) ) DecodeFields( Body, IntoBuffer );
+
+    return 0;
+}
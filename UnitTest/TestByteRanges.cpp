@@ -0,0 +1,69 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyTest.h"
+
+using namespace boost::ut;
+using namespace std::string_literals;
+
+using HTTP::ParseByteRanges;
+
+// ranges as "First+Length ...", readable in a failed expect
+auto Ranges( std::string_view Field, std::size_t Total )
+{
+    auto Result = std::string{};
+    for( auto [First, Length] : ParseByteRanges( Field, Total ).value_or( std::vector<HTTP::ByteRange>{} ) )
+        Result += std::to_string( First ) + "+" + std::to_string( Length ) + " ";
+    return Result;
+}
+
+int main()
+{
+    "closed range"_test = [] {
+        expect( Ranges( "bytes=0-99", 1000 ) == "0+100 "s );
+        expect( Ranges( "bytes=10-2000", 1000 ) == "10+990 "s ) << "last clamped to total";
+        expect( Ranges( " bytes=5-5 ", 1000 ) == "5+1 "s );
+    };
+
+    "open range"_test = [] {
+        expect( Ranges( "bytes=500-", 1000 ) == "500+500 "s );
+        expect( Ranges( "bytes=999-", 1000 ) == "999+1 "s );
+    };
+
+    "suffix range"_test = [] {
+        expect( Ranges( "bytes=-100", 1000 ) == "900+100 "s );
+        expect( Ranges( "bytes=-5000", 1000 ) == "0+1000 "s ) << "suffix longer than total";
+        expect( Ranges( "bytes=-99999999999999999999999999", 1000 ) == "0+1000 "s ) << "saturates";
+    };
+
+    "multiple ranges sorted, overlapping and adjacent ones merged"_test = [] {
+        expect( Ranges( "bytes=0-10, 5-20", 1000 ) == "0+21 "s );
+        expect( Ranges( "bytes=-10,0-0,,", 1000 ) == "0+1 990+10 "s );
+        expect( Ranges( "bytes=10-19,0-9,30-39", 1000 ) == "0+20 30+10 "s ) << "adjacent";
+        expect( Ranges( "bytes=0-99,10-19", 1000 ) == "0+100 "s ) << "contained";
+        expect( Ranges( "bytes=500-599,-100,0-0", 1000 ) == "0+1 500+100 900+100 "s );
+    };
+
+    "too many or too much is served whole"_test = [] {
+        auto Many = std::string{ "bytes=0-0" };
+        for( auto Index = 1uz; Index < HTTP::ByteRangeLimit; ++Index ) Many += "," + std::to_string( Index * 2 ) + "-" + std::to_string( Index * 2 );
+        expect( ParseByteRanges( Many, 1000 ).has_value() ) << "at the limit";
+        expect( ! ParseByteRanges( Many + ",500-500", 1000 ).has_value() ) << "beyond the limit";
+        expect( ! ParseByteRanges( "bytes=0-,0-", 1000 ).has_value() );
+        expect( ! ParseByteRanges( "bytes=0-599,400-", 1000 ).has_value() ) << "overlap adds up past the total";
+        expect( Ranges( "bytes=0-499,400-899", 1000 ) == "0+900 "s ) << "overlap within the total";
+    };
+
+    "unsatisfiable ranges are dropped"_test = [] {
+        for( auto [Field, Total] : { std::pair{ "bytes=2000-", 1000uz }, { "bytes=1000-1000", 1000uz }, { "bytes=-0", 1000uz }, { "bytes=0-", 0uz } } )
+        {
+            auto Result = ParseByteRanges( Field, Total );
+            expect( Result.has_value() && Result->empty() ) << Field;
+        }
+        expect( Ranges( "bytes=2000-3000,0-1", 1000 ) == "0+2 "s );
+    };
+
+    "malformed ranges"_test = [] {
+        for( auto Field : { "bytes=5-2", "bytes=+5-", "bytes=5-+9", "bytes=-+5", "bytes=0x10-", "bytes=5a-9", "bytes=1-2-3",
+                            "bytes=-", "bytes=5", "bytes=0-1,x", "items=0-1", "0-1", "" } )
+            expect( ! ParseByteRanges( Field, 1000 ).has_value() ) << Field;
+    };
+}
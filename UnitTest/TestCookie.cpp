@@ -0,0 +1,96 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyTest.h"
+
+using namespace boost::ut;
+using namespace std::string_view_literals;
+using EasyFCGI::StrView;
+using Cookie = decltype( EasyFCGI::Request::Cookie );
+
+// params carrying one Cookie field
+struct Params
+{
+    EasyFCGI::ParamList List;
+    EasyFCGI::ParamIndex Index;
+
+    explicit Params( StrView CookieField )
+    {
+        List.emplace_back( "HTTP_HOST", "example.com" );
+        if( ! CookieField.empty() ) List.emplace_back( "HTTP_COOKIE", CookieField );
+        Index.Build( List );
+    }
+};
+
+auto CookieOf( const Params& Source )
+{
+    auto Result = Cookie{};
+    Result.Reset( &Source.Index );
+    return Result;
+}
+
+int main()
+{
+    "fields split on ';' with surrounding spaces trimmed"_test = [] {
+        auto Source = Params{ "a=1; b=2;c=3 ;  d = 4" };
+        auto Jar = CookieOf( Source );
+        expect( Jar.size() == 4_u );
+        expect( Jar["a"] == "1"sv );
+        expect( Jar["b"] == "2"sv );
+        expect( Jar["c"] == "3"sv );
+        expect( Jar["d"] == "4"sv );
+    };
+
+    "missing cookies"_test = [] {
+        auto Source = Params{ "a=1" };
+        auto Jar = CookieOf( Source );
+        expect( Jar["b"].empty() );
+        expect( ! Jar.contains( "b" ) );
+        expect( ! Jar.contains( "A" ) ) << "names are case sensitive";
+
+        auto NoField = Params{ "" };
+        auto Empty = CookieOf( NoField );
+        expect( Empty.size() == 0_u );
+        expect( Empty["a"].empty() );
+        expect( Cookie{}.size() == 0_u ) << "never bound";
+    };
+
+    "empty values and empty segments"_test = [] {
+        auto Source = Params{ "a=; b; ;c=3;;=orphan" };
+        auto Jar = CookieOf( Source );
+        expect( Jar.contains( "a" ) && Jar["a"].empty() );
+        expect( Jar.contains( "b" ) && Jar["b"].empty() );
+        expect( Jar["c"] == "3"sv );
+        expect( Jar.size() == 3_u ) << "nameless segments dropped";
+    };
+
+    "parsed once, later lookups hit the cache"_test = [] {
+        auto Source = Params{ "a=1; b=2" };
+        auto Jar = CookieOf( Source );
+        expect( Jar["a"] == "1"sv );
+        auto First = &*Jar.begin();
+        Source.List.back().second = "a=changed";
+        expect( Jar["a"] == "1"sv );
+        expect( Jar["b"] == "2"sv );
+        expect( Jar.size() == 2_u );
+        expect( &*Jar.begin() == First );
+    };
+
+    "reset drops the cache"_test = [] {
+        auto Source = Params{ "a=1" };
+        auto Jar = CookieOf( Source );
+        expect( Jar["a"] == "1"sv );
+        auto Next = Params{ "b=2" };
+        Jar.Reset( &Next.Index );
+        expect( ! Jar.contains( "a" ) );
+        expect( Jar["b"] == "2"sv );
+    };
+
+    "moving takes the cache along and leaves the source empty"_test = [] {
+        auto Source = Params{ "a=1; b=2" };
+        auto Jar = CookieOf( Source );
+        expect( Jar.size() == 2_u );
+        auto Moved = std::move( Jar );
+        expect( Moved["b"] == "2"sv );
+        expect( Jar.size() == 0_u );
+        expect( Jar["a"].empty() );
+    };
+}
@@ -0,0 +1,96 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyTest.h"
+
+using namespace boost::ut;
+using namespace std::string_view_literals;
+
+namespace FCGI = FastCGI;
+
+auto Bytes( std::initializer_list<unsigned char> List )
+{
+    auto Result = std::string{};
+    for( auto Byte : List ) Result += static_cast<char>( Byte );
+    return Result;
+}
+
+int main()
+{
+    "RecordHeader round trip"_test = [] {
+        auto Raw = FCGI::EncodeHeader( FCGI::RecordType::Stdin, 0xABCD, 0xFFFF, 0xFF );
+        auto Header = FCGI::RecordHeader::Decode( Raw.data() );
+        expect( Header.Version == FCGI::Version );
+        expect( Header.Type == FCGI::RecordType::Stdin );
+        expect( Header.RequestID == 0xABCD );
+        expect( Header.ContentLength == 0xFFFF );
+        expect( Header.PaddingLength == 0xFF );
+        expect( Header.RecordLength() == FCGI::MaxRecordLength );
+    };
+
+    "RecordHeader from raw bytes"_test = [] {
+        auto Raw = Bytes( { 1, 6, 0, 1, 0x01, 0x02, 3, 0 } );
+        auto Header = FCGI::RecordHeader::Decode( Raw.data() );
+        expect( Header.Type == FCGI::RecordType::Stdout );
+        expect( Header.RequestID == 1_i );
+        expect( Header.ContentLength == 0x0102 );
+        expect( Header.RecordLength() == 8 + 0x0102 + 3 );
+    };
+
+    "DecodeLength 1 byte"_test = [] {
+        auto Raw = Bytes( { 0x7F, 'x' } );
+        auto Input = std::string_view{ Raw };
+        expect( FCGI::DecodeLength( Input ) == 0x7Fuz );
+        expect( Input == "x"sv );
+    };
+
+    "DecodeLength 4 bytes"_test = [] {
+        auto Raw = Bytes( { 0x80, 0, 1, 0, 'x' } );
+        auto Input = std::string_view{ Raw };
+        expect( FCGI::DecodeLength( Input ) == 256uz );
+        expect( Input == "x"sv );
+
+        auto MaxRaw = Bytes( { 0xFF, 0xFF, 0xFF, 0xFF } );
+        auto MaxInput = std::string_view{ MaxRaw };
+        expect( FCGI::DecodeLength( MaxInput ) == 0x7FFFFFFFuz );
+        expect( MaxInput.empty() );
+    };
+
+    "DecodeLength truncated"_test = [] {
+        auto Empty = std::string_view{};
+        expect( ! FCGI::DecodeLength( Empty ) );
+
+        auto Raw = Bytes( { 0x80, 0, 1 } );
+        auto Input = std::string_view{ Raw };
+        expect( ! FCGI::DecodeLength( Input ) );
+        expect( Input.size() == 3_u ) << "nothing consumed";
+    };
+
+    "DecodeNameValuePair round trip"_test = [] {
+        auto LongValue = std::string( 300, 'v' );
+        auto Raw = std::string{};
+        FCGI::EncodeNameValuePair( Raw, "SCRIPT_NAME", "/index" );
+        FCGI::EncodeNameValuePair( Raw, "HTTP_LONG", LongValue );
+        FCGI::EncodeNameValuePair( Raw, "EMPTY", "" );
+        expect( Raw.size() == 2 + 11 + 6 + 1 + 4 + 9 + 300 + 2 + 5 );
+
+        auto Input = std::string_view{ Raw };
+        auto First = FCGI::DecodeNameValuePair( Input );
+        auto Second = FCGI::DecodeNameValuePair( Input );
+        auto Third = FCGI::DecodeNameValuePair( Input );
+        expect( First.has_value() && First->first == "SCRIPT_NAME"sv && First->second == "/index"sv );
+        expect( Second.has_value() && Second->first == "HTTP_LONG"sv && Second->second == LongValue );
+        expect( Third.has_value() && Third->first == "EMPTY"sv && Third->second.empty() );
+        expect( Input.empty() );
+        expect( ! FCGI::DecodeNameValuePair( Input ) );
+    };
+
+    "DecodeNameValuePair truncated"_test = [] {
+        auto Raw = std::string{};
+        FCGI::EncodeNameValuePair( Raw, "NAME", std::string( 200, 'v' ) );
+        for( auto Cut : { 1uz, 3uz, 5uz, 9uz, Raw.size() - 1 } )
+        {
+            auto Input = std::string_view{ Raw }.substr( 0, Cut );
+            expect( ! FCGI::DecodeNameValuePair( Input ) ) << "cut at" << Cut;
+            expect( Input.size() == Cut ) << "nothing consumed";
+        }
+    };
+}
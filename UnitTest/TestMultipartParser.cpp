@@ -0,0 +1,134 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyTest.h"
+
+using namespace boost::ut;
+using namespace std::string_literals;
+using EasyFCGI::StrView;
+
+struct Part
+{
+    std::string Header;
+    std::string Content;
+    bool Ended{ false };
+};
+
+struct ParseResult
+{
+    std::vector<Part> Parts;
+    bool Done{ false };
+    std::size_t MaxWindow{ 0 };
+};
+
+// feeds Body to a fresh parser in chunks of ChunkSize
+auto Parse( StrView Body, std::size_t ChunkSize, StrView Boundary = "XyZ" )
+{
+    auto Parser = EasyFCGI::MultipartParser{ Boundary };
+    auto Result = ParseResult{};
+    auto OnPart = [&]( StrView Header ) { Result.Parts.push_back( { std::string{ Header } } ); };
+    auto OnContent = [&]( StrView Content ) { Result.Parts.back().Content += Content; };
+    auto OnPartEnd = [&] { Result.Parts.back().Ended = true; };
+    for( auto Offset = 0uz; Offset < Body.size() && ! Parser.Done(); Offset += ChunkSize )
+    {
+        Parser.Feed( Body.substr( Offset, ChunkSize ), OnPart, OnContent, OnPartEnd );
+        Result.MaxWindow = std::max( Result.MaxWindow, Parser.Window.size() );
+    }
+    Result.Done = Parser.Done();
+    return Result;
+}
+
+const auto SampleBody = "preamble, ignored\r\n"
+                        "--XyZ\r\n"
+                        "Content-Disposition: form-data; name=\"field\"\r\n"
+                        "\r\n"
+                        "value with --XyZ look-alike and \r\n--XY inside\r\n"
+                        "--XyZ\r\n"
+                        "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "\r\n"
+                        "line 1\r\nline 2\r\n"
+                        "--XyZ--\r\n"
+                        "epilogue, ignored"s;
+
+auto ExpectSample( const ParseResult& Result )
+{
+    expect( Result.Done );
+    expect( Result.Parts.size() == 2_u );
+    if( Result.Parts.size() != 2 ) return;
+    expect( Result.Parts[0].Header == "Content-Disposition: form-data; name=\"field\""s );
+    expect( Result.Parts[0].Content == "value with --XyZ look-alike and \r\n--XY inside"s );
+    expect( Result.Parts[1].Header == "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\nContent-Type: text/plain"s );
+    expect( Result.Parts[1].Content == "line 1\r\nline 2"s );
+    expect( Result.Parts[0].Ended && Result.Parts[1].Ended );
+}
+
+int main()
+{
+    "sample body at various chunk sizes"_test = [] {
+        for( auto ChunkSize : { 1uz, 2uz, 3uz, 7uz, 1000uz } )
+            test( "chunk size " + std::to_string( ChunkSize ) ) = [=] { ExpectSample( Parse( SampleBody, ChunkSize ) ); };
+    };
+
+    "delimiter split across two chunks"_test = [] {
+        auto Delimiter = SampleBody.find( "\r\n--XyZ\r\nContent-Disposition: form-data; name=\"file\"" );
+        for( auto Cut = Delimiter; Cut <= Delimiter + 9; ++Cut )
+        {
+            auto Parser = EasyFCGI::MultipartParser{ "XyZ" };
+            auto Result = ParseResult{};
+            auto OnPart = [&]( StrView Header ) { Result.Parts.push_back( { std::string{ Header } } ); };
+            auto OnContent = [&]( StrView Content ) { Result.Parts.back().Content += Content; };
+            auto OnPartEnd = [&] { Result.Parts.back().Ended = true; };
+            Parser.Feed( StrView{ SampleBody }.substr( 0, Cut ), OnPart, OnContent, OnPartEnd );
+            Parser.Feed( StrView{ SampleBody }.substr( Cut ), OnPart, OnContent, OnPartEnd );
+            Result.Done = Parser.Done();
+            ExpectSample( Result );
+        }
+    };
+
+    "body without preamble"_test = [] {
+        auto Body = "--XyZ\r\n\r\nfirst\r\n--XyZ--"s;
+        auto Result = Parse( Body, 4 );
+        expect( Result.Done );
+        expect( Result.Parts.size() == 1_u );
+        if( Result.Parts.size() == 1 )
+        {
+            expect( Result.Parts[0].Header.empty() );
+            expect( Result.Parts[0].Content == "first"s );
+        }
+    };
+
+    "transport padding after delimiter"_test = [] {
+        auto Body = "--XyZ \t \r\nName: a\r\n\r\nA\r\n--XyZ\t\r\nName: b\r\n\r\nB\r\n--XyZ--"s;
+        for( auto ChunkSize : { 1uz, 1000uz } )
+        {
+            auto Result = Parse( Body, ChunkSize );
+            expect( Result.Done );
+            expect( Result.Parts.size() == 2_u );
+            if( Result.Parts.size() != 2 ) continue;
+            expect( Result.Parts[0].Header == "Name: a"s && Result.Parts[0].Content == "A"s );
+            expect( Result.Parts[1].Header == "Name: b"s && Result.Parts[1].Content == "B"s );
+        }
+    };
+
+    "truncated body is not done"_test = [] {
+        auto Result = Parse( SampleBody.substr( 0, SampleBody.find( "line 2" ) ), 5 );
+        expect( ! Result.Done );
+        expect( Result.Parts.size() == 2_u );
+        if( Result.Parts.size() == 2 ) expect( ! Result.Parts[1].Ended );
+    };
+
+    "header block beyond the limit ends parsing"_test = [] {
+        auto Body = "--XyZ\r\nName: " + std::string( EasyFCGI::Config::MultipartHeaderLimit * 2, 'h' ) + "\r\n\r\ncontent\r\n--XyZ--";
+        auto Result = Parse( Body, 1000 );
+        expect( Result.Done );
+        expect( Result.Parts.empty() );
+        expect( Result.MaxWindow <= EasyFCGI::Config::MultipartHeaderLimit + 1000 );
+    };
+
+    "delimiter line beyond the limit ends parsing"_test = [] {
+        auto Body = "--XyZ" + std::string( EasyFCGI::Config::MultipartHeaderLimit * 2, ' ' ) + "\r\n\r\ncontent\r\n--XyZ--";
+        auto Result = Parse( Body, 1000 );
+        expect( Result.Done );
+        expect( Result.Parts.empty() );
+        expect( Result.MaxWindow <= EasyFCGI::Config::MultipartHeaderLimit + 1000 );
+    };
+}
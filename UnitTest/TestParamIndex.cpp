@@ -0,0 +1,101 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyTest.h"
+
+using namespace boost::ut;
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+using EasyFCGI::ParamIndex;
+using EasyFCGI::ParamList;
+using EasyFCGI::StrView;
+
+// owns the text a ParamList points into
+struct Params
+{
+    std::deque<std::string> Text;
+    ParamList List;
+    ParamIndex Index;
+
+    auto Add( std::string Name, std::string Value ) -> Params&
+    {
+        auto& StoredName = Text.emplace_back( std::move( Name ) );
+        auto& StoredValue = Text.emplace_back( std::move( Value ) );
+        List.emplace_back( StoredName, StoredValue );
+        return *this;
+    }
+    auto Build() -> Params&
+    {
+        Index.Build( List );
+        return *this;
+    }
+};
+
+auto SlotOf( StrView Name ) { return ParamIndex::Hash( {}, Name ) & ParamIndex::Mask; }
+
+int main()
+{
+    "header names fold case and dashes"_test = [] {
+        auto Request = Params{};
+        Request.Add( "HTTP_USER_AGENT", "agent" ).Add( "HTTP_X_FORWARDED_FOR", "10.0.0.1" ).Add( "SCRIPT_NAME", "/index" ).Build();
+        expect( Request.Index.Find( "HTTP_", "User-Agent" ) == "agent"sv );
+        expect( Request.Index.Find( "HTTP_", "x-forwarded-for" ) == "10.0.0.1"sv );
+        expect( Request.Index.Find( "HTTP_", "X_FORWARDED_FOR" ) == "10.0.0.1"sv );
+        expect( Request.Index.Find( "http_user-agent" ) == "agent"sv );
+    };
+
+    "other CGI variables compare exactly"_test = [] {
+        auto Request = Params{};
+        Request.Add( "SCRIPT_NAME", "/index" ).Add( "QUERY_STRING", "a=1" ).Add( "HTTP_HOST", "example.com" ).Build();
+        expect( Request.Index.Find( "SCRIPT_NAME" ) == "/index"sv );
+        expect( Request.Index.Find( "QUERY_STRING" ) == "a=1"sv );
+        expect( Request.Index.Find( "script_name" ).empty() );
+        expect( Request.Index.Find( "SCRIPT-NAME" ).empty() );
+        expect( Request.Index.Find( "Query_String" ).empty() );
+    };
+
+    "missing keys"_test = [] {
+        auto Request = Params{};
+        Request.Add( "HTTP_HOST", "example.com" ).Add( "EMPTY", "" ).Build();
+        expect( Request.Index.Find( "HTTP_", "Accept" ).empty() );
+        expect( Request.Index.Find( "HOST" ).empty() );
+        expect( Request.Index.Find( "HTTP_HOSTX" ).empty() );
+        expect( Request.Index.Find( "" ).empty() );
+        expect( ParamIndex{}.Find( "HTTP_HOST" ).empty() ) << "never built";
+    };
+
+    "names sharing a slot"_test = [] {
+        auto First = "HTTP_X_0"s;
+        auto Second = std::string{};
+        for( auto Index = 1; Second.empty(); ++Index )
+            if( auto Name = "HTTP_X_" + std::to_string( Index ); SlotOf( Name ) == SlotOf( First ) ) Second = Name;
+        auto Third = std::string{};
+        for( auto Index = 0; Third.empty(); ++Index )
+            if( auto Name = "VAR_" + std::to_string( Index ); SlotOf( Name ) == SlotOf( First ) ) Third = Name;
+
+        auto Request = Params{};
+        Request.Add( First, "first" ).Add( Second, "second" ).Add( Third, "third" ).Build();
+        expect( Request.Index.Find( First ) == "first"sv );
+        expect( Request.Index.Find( Second ) == "second"sv );
+        expect( Request.Index.Find( Third ) == "third"sv );
+        expect( Request.Index.Find( "HTTP_X_NONE" ).empty() );
+    };
+
+    "first of duplicated names wins"_test = [] {
+        auto Request = Params{};
+        Request.Add( "HTTP_ACCEPT", "first" ).Add( "HTTP_ACCEPT", "second" ).Build();
+        expect( Request.Index.Find( "HTTP_", "Accept" ) == "first"sv );
+    };
+
+    "lists beyond the table are scanned"_test = [] {
+        for( auto Count : { ParamIndex::Capacity / 2, ParamIndex::Capacity / 2 + 1, ParamIndex::Capacity * 2 } )
+        {
+            auto Request = Params{};
+            for( auto Index = 0uz; Index < Count; ++Index ) Request.Add( "HTTP_X_" + std::to_string( Index ), std::to_string( Index ) );
+            Request.Add( "SCRIPT_NAME", "/index" ).Build();
+            for( auto Index = 0uz; Index < Count; ++Index )
+                expect( Request.Index.Find( "HTTP_", "x-" + std::to_string( Index ) ) == std::to_string( Index ) ) << Count << Index;
+            expect( Request.Index.Find( "SCRIPT_NAME" ) == "/index"sv ) << Count;
+            expect( Request.Index.Find( "script_name" ).empty() ) << Count;
+            expect( Request.Index.Find( "HTTP_", "x-" + std::to_string( Count ) ).empty() ) << Count;
+        }
+    };
+}
@@ -0,0 +1,74 @@
+#include <EasyMeta.h>
+#include <EasyTest.h>
+
+using namespace EasyMeta;
+using namespace boost::ut;
+using namespace std::string_view_literals;
+
+enum class Color { Red, Green, Blue, Purple = 100 };
+
+constexpr auto Methods = MakePerfectHash<std::string_view, int>( {
+    { "GET", 1 },
+    { "HEAD", 2 },
+    { "POST", 3 },
+    { "PUT", 4 },
+    { "DELETE", 5 },
+} );
+
+constexpr auto ColorNames = MakePerfectHash<Color, std::string_view>( {
+    { Color::Red, "red" },
+    { Color::Green, "green" },
+    { Color::Blue, "blue" },
+    { Color::Purple, "purple" },
+} );
+
+// a key landing on the slot of key 0 in a two entry table hashed with seed 0
+constexpr auto CollidingKey = [] {
+    using Table = PerfectHash<int, int, 2>;
+    auto Mask = Table::TableSize - 1;
+    auto Key = 1;
+    while( ( Table::Hash( Key, 0 ) & Mask ) != ( Table::Hash( 0, 0 ) & Mask ) ) ++Key;
+    return Key;
+}();
+
+constexpr auto Colliding = MakePerfectHash<int, int>( { { 0, 10 }, { CollidingKey, 20 } } );
+
+// construction usable in a constant expression, the seed search throws on duplicated keys
+template<auto Build>
+concept BuildsAtCompileTime = requires { typename std::bool_constant<( Build(), true )>; };
+
+int main()
+{
+    "string keys"_test = [] {
+        static_assert( Methods.FindOr( "POST", 0 ) == 3 );
+        expect( Methods.FindOr( "GET", 0 ) == 1_i );
+        expect( Methods.FindOr( "DELETE", 0 ) == 5_i );
+        expect( Methods.Find( "HEAD" ) != nullptr && *Methods.Find( "HEAD" ) == 2_i );
+        for( auto Miss : { "get"sv, "PATCH"sv, ""sv, "GETX"sv, "POS"sv } )
+        {
+            expect( Methods.Find( Miss ) == nullptr ) << Miss;
+            expect( Methods.FindOr( Miss, -1 ) == -1_i ) << Miss;
+        }
+    };
+
+    "enum keys"_test = [] {
+        static_assert( ColorNames.FindOr( Color::Purple, "" ) == "purple" );
+        expect( ColorNames.FindOr( Color::Red, "" ) == "red"sv );
+        expect( ColorNames.FindOr( Color::Blue, "" ) == "blue"sv );
+        expect( ColorNames.Find( static_cast<Color>( 3 ) ) == nullptr );
+        expect( ColorNames.FindOr( static_cast<Color>( 42 ), "none" ) == "none"sv );
+    };
+
+    "keys colliding under seed 0 get another seed"_test = [] {
+        static_assert( Colliding.Seed != 0 );
+        expect( Colliding.FindOr( 0, -1 ) == 10_i );
+        expect( Colliding.FindOr( CollidingKey, -1 ) == 20_i );
+        expect( Colliding.Find( CollidingKey + 1 ) == nullptr );
+    };
+
+    "duplicated keys do not build at compile time"_test = [] {
+        static_assert( BuildsAtCompileTime<[] { return MakePerfectHash<int, int>( { { 1, 1 }, { 2, 2 } } ); }> );
+        static_assert( ! BuildsAtCompileTime<[] { return MakePerfectHash<int, int>( { { 1, 1 }, { 1, 2 } } ); }> );
+        static_assert( ! BuildsAtCompileTime<[] { return MakePerfectHash<std::string_view, int>( { { "a", 1 }, { "b", 2 }, { "a", 3 } } ); }> );
+    };
+}
@@ -0,0 +1,103 @@
+#include "../EasyFCGI.hpp"
+#include "../EasyTest.h"
+#include <random>
+
+using namespace boost::ut;
+using namespace std::string_literals;
+using EasyFCGI::StrView;
+
+// one byte at a time, the rules DecodeURLInto is meant to follow
+auto ReferenceDecode( StrView Fragment )
+{
+    auto Result = std::string{};
+    for( auto Index = 0uz; Index < Fragment.size(); ++Index )
+    {
+        auto C = Fragment[Index];
+        if( C == '+' ) { Result += ' '; continue; }
+        if( C != '%' ) { Result += C; continue; }
+        auto High = Index + 1 < Fragment.size() ? ParseUtil::HexValue( Fragment[Index + 1] ) : 16;
+        auto Low = High < 16 && Index + 2 < Fragment.size() ? ParseUtil::HexValue( Fragment[Index + 2] ) : 16;
+        if( Low < 16 )
+        {
+            Result += static_cast<char>( High << 4 | Low );
+            Index += 2;
+        }
+        else
+        {
+            Result += '?';
+            if( High < 16 ) ++Index;
+        }
+    }
+    return Result;
+}
+
+auto InPlace( std::string Text )
+{
+    Text.resize( ParseUtil::DecodeURLInto( Text, Text.data() ) );
+    return Text;
+}
+
+int main()
+{
+    "escapes"_test = [] {
+        expect( ParseUtil::DecodeURLFragment( "a%20b%2Fc%3a%3A" ) == "a b/c::"s );
+        expect( ParseUtil::DecodeURLFragment( "%E4%B8%AD" ) == "\xE4\xB8\xAD"s );
+        expect( ParseUtil::DecodeURLFragment( "%00" ) == "\0"s );
+        expect( ParseUtil::DecodeURLFragment( "plain text" ) == "plain text"s );
+        expect( ParseUtil::DecodeURLFragment( "" ).empty() );
+    };
+
+    "plus is space"_test = [] {
+        expect( ParseUtil::DecodeURLFragment( "a+b++" ) == "a b  "s );
+        expect( ParseUtil::DecodeURLFragment( "%2B+" ) == "+ "s );
+    };
+
+    "malformed escapes"_test = [] {
+        expect( ParseUtil::DecodeURLFragment( "%%41" ) == "?A"s );
+        expect( ParseUtil::DecodeURLFragment( "%4x" ) == "?x"s );
+        expect( ParseUtil::DecodeURLFragment( "%zz" ) == "?zz"s );
+        expect( ParseUtil::DecodeURLFragment( "%+A" ) == "? A"s );
+        expect( ParseUtil::DecodeURLFragment( "%4%41" ) == "?A"s );
+    };
+
+    "truncated escapes"_test = [] {
+        expect( ParseUtil::DecodeURLFragment( "%" ) == "?"s );
+        expect( ParseUtil::DecodeURLFragment( "%4" ) == "?"s );
+        expect( ParseUtil::DecodeURLFragment( "%%" ) == "??"s );
+        expect( ParseUtil::DecodeURLFragment( "abc%" ) == "abc?"s );
+        expect( ParseUtil::DecodeURLFragment( "abc%4" ) == "abc?"s );
+    };
+
+    "appends to existing content"_test = [] {
+        expect( ParseUtil::DecodeURLFragment( "b%20c", "a"s ) == "ab c"s );
+    };
+
+    "in place"_test = [] {
+        expect( InPlace( "a%20b+c%%41%4" ) == "a b c?A?"s );
+        expect( InPlace( "no escapes at all" ) == "no escapes at all"s );
+    };
+
+    "long inputs against the reference"_test = [] {
+        // escapes land on both sides of the 16 / 32 byte blocks
+        constexpr auto Alphabet = StrView{ "abcXYZ019%%%++ -Ff" };
+        auto Random = std::mt19937{ 2024 };
+        auto Pick = std::uniform_int_distribution<std::size_t>{ 0, Alphabet.size() - 1 };
+        for( auto Length : { 31uz, 32uz, 33uz, 47uz, 64uz, 100uz, 257uz } )
+            for( auto _ : std::views::iota( 0, 50 ) )
+            {
+                auto Input = std::string{};
+                for( auto _ : std::views::iota( 0uz, Length ) ) Input += Alphabet[Pick( Random )];
+                auto Expected = ReferenceDecode( Input );
+                expect( ParseUtil::DecodeURLFragment( Input ) == Expected ) << Input;
+                expect( InPlace( Input ) == Expected ) << "in place:" << Input;
+            }
+
+        auto Clean = std::string( 100, 'x' );
+        for( auto Position : { 0uz, 15uz, 16uz, 31uz, 32uz, 33uz, 63uz, 99uz } )
+        {
+            auto Input = Clean;
+            Input[Position] = '+';
+            expect( ParseUtil::DecodeURLFragment( Input ) == ReferenceDecode( Input ) ) << "'+' at" << Position;
+        }
+    };
+}